@@ -4,6 +4,8 @@
 
 // Contains everything required for syncrhonising/moving agents across processes. 
 // That includes the agent packages implementation, the package provider and receiver
+#ifndef AGENT_SYNCHRONISATION_PACKAGE_PATTERN
+#define AGENT_SYNCHRONISATION_PACKAGE_PATTERN
 
 /****************
 * Include Files
@@ -197,12 +199,20 @@ class VirusCellInteractionAgentsPackageReceiver {
 	
 private:
     repast::SharedContext<VirusCellInteractionAgents>* agentsContext;
+
+    // Whether the packages received are of agents moving to this process, rather than of copies for its buffer zone.
+    bool isReceivingMigratingAgents;
 	
 public:
 	
     VirusCellInteractionAgentsPackageReceiver(repast::SharedContext<VirusCellInteractionAgents>* agentPtr);
+
+    // Set by the model around the synchronisation of the agent status, so the agents moved to this process are added to its population counters.
+    void setReceivingMigratingAgents(bool isReceivingMigrating){    isReceivingMigratingAgents = isReceivingMigrating;    }
 	
     VirusCellInteractionAgents * createAgent(VirusCellInteractionAgentPackage package);
 	
     void updateAgent(VirusCellInteractionAgentPackage package);
-};
\ No newline at end of file
+};
+
+#endif // AGENT_SYNCHRONISATION_PACKAGE_PATTERN
@@ -0,0 +1,109 @@
+/* Bounded_Queue.h */
+#ifndef BOUNDED_QUEUE
+#define BOUNDED_QUEUE
+
+/**********************
+*   Include files
+**********************/
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+
+/**********************
+* Bounded Queue class. A fixed capacity, lock-free queue for passing items from exactly one producer thread to exactly one consumer thread.
+* Each side only writes its own index, and reads the other's with acquire ordering, so an item is fully written before the consumer can see it.
+* When the queue is full, push waits for the consumer to make room, which holds the producer back if the consumer falls behind.
+**********************/
+template<typename T>
+class BoundedQueue
+{
+private:
+    std::vector<T> slots;
+    size_t capacity;
+
+    // The count of items pushed and popped so far. The item at count c is kept in slot c % capacity.
+    std::atomic<size_t> pushedCount;
+    std::atomic<size_t> poppedCount;
+
+public:
+    explicit BoundedQueue(size_t theCapacity);
+
+    // Called by the producer only. Returns false if the queue is full.
+    bool tryPush(const T& item);
+
+    // Called by the producer only. Waits until there is room for the item.
+    void push(const T& item);
+
+    // Called by the consumer only. Returns false if the queue is empty.
+    bool tryPop(T& item);
+};
+
+
+
+/**********************
+*   BoundedQueue::BoundedQueue - Constructor. Creates an empty queue which can hold the passed count of items.
+**********************/
+template<typename T>
+BoundedQueue<T>::BoundedQueue(size_t theCapacity):
+slots(theCapacity),
+capacity(theCapacity),
+pushedCount(0),
+poppedCount(0)
+{
+}
+
+
+
+/**********************
+*   BoundedQueue::tryPush - Adds the item at the back of the queue, if there is room for it.
+**********************/
+template<typename T>
+bool BoundedQueue<T>::tryPush(const T& item)
+{
+    size_t pushed = pushedCount.load(std::memory_order_relaxed);
+    if( pushed - poppedCount.load(std::memory_order_acquire) == capacity )
+    {
+        return false;
+    }
+
+    slots[pushed % capacity] = item;
+    pushedCount.store(pushed + 1, std::memory_order_release);
+    return true;
+}
+
+
+
+/**********************
+*   BoundedQueue::push - Adds the item at the back of the queue, yielding to the consumer for as long as the queue is full.
+**********************/
+template<typename T>
+void BoundedQueue<T>::push(const T& item)
+{
+    while( !tryPush(item) )
+    {
+        std::this_thread::yield();
+    }
+}
+
+
+
+/**********************
+*   BoundedQueue::tryPop - Takes the item at the front of the queue, if there is one.
+**********************/
+template<typename T>
+bool BoundedQueue<T>::tryPop(T& item)
+{
+    size_t popped = poppedCount.load(std::memory_order_relaxed);
+    if( popped == pushedCount.load(std::memory_order_acquire) )
+    {
+        return false;
+    }
+
+    item = slots[popped % capacity];
+    poppedCount.store(popped + 1, std::memory_order_release);
+    return true;
+}
+
+#endif // BOUNDED_QUEUE
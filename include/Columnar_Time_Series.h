@@ -0,0 +1,91 @@
+/* Columnar_Time_Series.h */
+#ifndef COLUMNAR_TIME_SERIES
+#define COLUMNAR_TIME_SERIES
+
+/**********************
+*   Include files
+**********************/
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+/**********************
+* The binary columnar time-series format. A file holds a header followed by any count of chunks, each appended in one piece.
+*
+*   Header: "VCTS", version (u32), parameters hash (u64), random seed (u64), columns count (u32),
+*           then for each column its type (u8) and name (u32 length, then the characters).
+*   Chunk:  rows count (u32), then for each column the byte count of its encoded values (u32) and the encoded values.
+*
+* The float64 columns hold the raw values. The int64 columns hold the differences between consecutive values, zigzag encoded and written
+* as base-128 varints, so the slowly changing counts take a byte or two per row. The differences restart at 0 in each chunk, so every chunk
+* can be decoded on its own, and a chunk cut short by a crash is simply ignored. All integers are little-endian.
+**********************/
+enum ColumnarColumnType{ Float64Column = 0, Int64Column = 1 };
+
+
+/**********************
+* Columnar Time Series Writer class. Writes a time series whose first column is the tick (float64) and whose other columns are int64 values.
+**********************/
+class ColumnarTimeSeriesWriter
+{
+private:
+    std::ofstream output;
+    size_t valueColumnsCount;
+
+public:
+    ColumnarTimeSeriesWriter(std::string fileName, uint64_t parametersHash, uint64_t seed, const std::vector<std::string>& valueColumnNames);
+
+    // Appends the passed rows as a chunk. The values are in row-major order, valueColumnsCount per tick.
+    void appendChunk(const std::vector<double>& ticks, const std::vector<long long>& values);
+
+    // Hashes the passed text (64-bit FNV-1a), e.g. the parameters of the simulation, for the header.
+    static uint64_t hashText(const std::string& text);
+};
+
+
+
+/**********************
+* Columnar Time Series Reader class. Maps a file written by the writer into memory and decodes its columns on request.
+**********************/
+class ColumnarTimeSeriesReader
+{
+private:
+    const unsigned char* fileData;
+    size_t fileSize;
+
+    uint64_t parametersHash;
+    uint64_t seed;
+    std::vector<std::string> columnNames;
+    std::vector<int> columnTypes;
+
+    // For each complete chunk, its rows count and the offsets of the encoded values of each of its columns (and their byte counts).
+    std::vector<uint32_t> chunkRowsCounts;
+    std::vector<std::vector<size_t> > chunkColumnOffsets;
+    std::vector<std::vector<uint32_t> > chunkColumnBytes;
+
+public:
+    ColumnarTimeSeriesReader();
+    ~ColumnarTimeSeriesReader();
+
+    // Maps the file and reads its header and chunk layout. Returns false if the file cannot be read or is not in the columnar format.
+    bool open(std::string fileName);
+
+    uint64_t getParametersHash() const {                            return parametersHash;          }
+    uint64_t getSeed() const {                                      return seed;                    }
+    size_t getColumnsCount() const {                                return columnNames.size();      }
+    const std::string& getColumnName(size_t column) const {         return columnNames[column];     }
+    int getColumnType(size_t column) const {                        return columnTypes[column];     }
+    size_t getRowsCount() const;
+
+    // Decode the whole of the passed column, over all chunks.
+    void readFloat64Column(size_t column, std::vector<double>& values) const;
+    void readInt64Column(size_t column, std::vector<long long>& values) const;
+
+private:
+    void close();
+};
+
+#endif // COLUMNAR_TIME_SERIES
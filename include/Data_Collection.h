@@ -1,8 +1,12 @@
 /***********************************
 ***** DATA COLLECTION CLASSES *****
 ***********************************/
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <boost/mpi.hpp>
 #include "repast_hpc/TDataSource.h"
-#include "repast_hpc/SVDataSet.h"
 #include "repast_hpc/SharedContext.h"
 
 // Include agent related files
@@ -11,6 +15,18 @@
 #include "Virion_Agent.h"
 #include "Innate_Immune_Cell.h"
 #include "Specialised_Immune_Cell.h"
+#include "Population_Counters.h"
+#include "Columnar_Time_Series.h"
+#include "Bounded_Queue.h"
+#include "Plaque_Analysis.h"
+#include "Infection_Front.h"
+#include "Termination_Criteria.h"
+
+
+/**********************
+* The data sources read the counts of the local agents from the population counters of the process. 
+* If cross-checking is enabled, each count is also taken by scanning the local agents and any difference is reported. That is only meant for debugging.
+**********************/
 
 
 /**********************
@@ -19,9 +35,12 @@
 class DataSource_EpithelialCellsCount : public repast::TDataSource<int>{
 private:
 	repast::SharedContext<VirusCellInteractionAgents>* context;
+	bool isCrossChecked;
+
+	int countByScan();
     
 public:
-	DataSource_EpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext);
+	DataSource_EpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked);
 	int getData();
 };
 
@@ -32,9 +51,12 @@ public:
 class DataSource_VirionsCount : public repast::TDataSource<int>{
 private:
 	repast::SharedContext<VirusCellInteractionAgents>* context;
+	bool isCrossChecked;
+
+	int countByScan();
     
 public:
-	DataSource_VirionsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext);
+	DataSource_VirionsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked);
 	int getData();
 };
 
@@ -45,9 +67,12 @@ public:
 class DataSource_InnateImmuneCellsCount : public repast::TDataSource<int>{
 private:
 	repast::SharedContext<VirusCellInteractionAgents>* context;
+	bool isCrossChecked;
+
+	int countByScan();
     
 public:
-	DataSource_InnateImmuneCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext);
+	DataSource_InnateImmuneCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked);
 	int getData();
 };
 
@@ -59,9 +84,12 @@ public:
 class DataSource_SpecialisedImmuneCellsCount : public repast::TDataSource<int>{
 private:
 	repast::SharedContext<VirusCellInteractionAgents>* context;
+	bool isCrossChecked;
+
+	int countByScan();
     
 public:
-	DataSource_SpecialisedImmuneCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext);
+	DataSource_SpecialisedImmuneCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked);
 	int getData();
 };
 
@@ -74,9 +102,12 @@ class DataSource_InfectedEpithelialCellsCount : public repast::TDataSource<int>
 {
 private:
 	repast::SharedContext<VirusCellInteractionAgents>* context;
+	bool isCrossChecked;
+
+	int countByScan();
     
 public:
-	DataSource_InfectedEpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext);
+	DataSource_InfectedEpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked);
 	int getData();
 };
 
@@ -89,9 +120,12 @@ class DataSource_DeadEpithelialCellsCount : public repast::TDataSource<int>
 {
 private:
 	repast::SharedContext<VirusCellInteractionAgents>* context;
+	bool isCrossChecked;
+
+	int countByScan();
     
 public:
-	DataSource_DeadEpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext);
+	DataSource_DeadEpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked);
 	int getData();
 };
 
@@ -104,8 +138,192 @@ class DataSource_TotalAgentsCount : public repast::TDataSource<int>
 {
 private:
 	repast::SharedContext<VirusCellInteractionAgents>* context;
+	bool isCrossChecked;
+
+	int countByScan();
+    
+public:
+	DataSource_TotalAgentsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked);
+	int getData();
+};
+
+
+
+/**********************
+* The plaque data sources read the results of the last plaque analysis, which are only available on rank 0. The other processes report 0,
+* so the sum taken by the recorder is the value for the whole grid.
+**********************/
+
+
+/**********************
+* Data Source class for tracking the count of plaques in the model
+**********************/
+class DataSource_PlaqueCount : public repast::TDataSource<int>
+{
+private:
+	PlaqueAnalysis* plaqueAnalysis;
     
 public:
-	DataSource_TotalAgentsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext);
+	DataSource_PlaqueCount(PlaqueAnalysis* thePlaqueAnalysis);
 	int getData();
-};
\ No newline at end of file
+};
+
+
+
+/**********************
+* Data Source class for tracking the area of the largest plaque in the model
+**********************/
+class DataSource_LargestPlaqueArea : public repast::TDataSource<int>
+{
+private:
+	PlaqueAnalysis* plaqueAnalysis;
+    
+public:
+	DataSource_LargestPlaqueArea(PlaqueAnalysis* thePlaqueAnalysis);
+	int getData();
+};
+
+
+
+/**********************
+* Data Source class for tracking the count of plaques in one bin of the plaque size distribution
+**********************/
+class DataSource_PlaqueSizeCount : public repast::TDataSource<int>
+{
+private:
+	PlaqueAnalysis* plaqueAnalysis;
+	int sizeBin;
+    
+public:
+	DataSource_PlaqueSizeCount(PlaqueAnalysis* thePlaqueAnalysis, int theSizeBin);
+	int getData();
+};
+
+
+
+/**********************
+* Data Source class for tracking one quantity of the infection front around a focus. The tracker's results are the same on all processes,
+* so only rank 0 reports them, and the other processes report 0. The lengths are reported in hundredths of a site (and per tick for the velocity),
+* as the recorder only holds whole numbers. The centroids are reported in the coordinates of the model.
+**********************/
+class DataSource_InfectionFront : public repast::TDataSource<int>
+{
+public:
+	enum Quantity{ CentroidX, CentroidY, RadiusOfGyration, MaxInfectedRadius, FrontVelocity };
+
+private:
+	InfectionFrontTracker* frontTracker;
+	int focus;
+	Quantity quantity;
+	int originCoordinate;
+    
+public:
+	DataSource_InfectionFront(InfectionFrontTracker* theFrontTracker, int theFocus, Quantity theQuantity, int theOriginCoordinate);
+	int getData();
+};
+
+
+
+/**********************
+* An item passed from the recorder to its writer thread: a completed record, a request to write the records so far, or a request to stop.
+**********************/
+struct AgentsDataQueueItem
+{
+    enum Kind{ Record, Write, Stop };
+
+    int kind;
+    double tick;
+    std::vector<long long> values;
+};
+
+
+
+/**********************
+* Agents Data Recorder class. Records the values of its data sources, summed over all processes, and writes them to a CSV file on rank 0.
+* All values of a record are summed in a single non-blocking reduction. It is started when the values are recorded, right after the timestep,
+* and only completed at the next record or write, so the processes continue with the next timestep while it is in flight.
+* On rank 0 the completed records are handed to a writer thread through a bounded queue, so the formatting, compression and syncing of the files 
+* never hold up the timesteps. The writer thread makes no MPI calls. If it falls behind and the queue fills up, the recorder waits for it.
+* With termination criteria, the values are summed onto all processes instead, and the criteria are checked on each completed record.
+**********************/
+class AgentsDataRecorder
+{
+private:
+    MPI_Comm recorderComm;
+    int rank;
+
+    std::vector<std::string> columnNames;
+    std::vector<repast::TDataSource<int>*> dataSources;
+
+    // The values of this process, and their sums over the processes (only valid on rank 0, unless there are termination criteria), for the record in flight.
+    std::vector<long long> localValues;
+    std::vector<long long> summedValues;
+    MPI_Request reductionRequest;
+    bool isReductionInFlight;
+    double tickInFlight;
+
+    // The queue to the writer thread, and the thread itself (rank 0 only).
+    BoundedQueue<AgentsDataQueueItem> writerQueue;
+    std::thread writerThread;
+
+    // The completed records not yet written to the file. These and the output files below are only used by the writer thread.
+    std::vector<double> recordedTicks;
+    std::vector<long long> recordedValues;
+
+    std::string outputFileName;
+    std::ofstream output;
+
+    // The records kept in memory for the embedding program, in the layout of the records waiting to be written (on all processes once shared).
+    bool isRetainingRecords;
+    std::vector<double> retainedTicks;
+    std::vector<long long> retainedValues;
+
+    // The criteria for stopping the simulation early, checked on each completed record (nullptr if there are none). Not owned by the recorder.
+    TerminationCriteria* terminationCriteria;
+
+    // The optional binary columnar copy of the output (rank 0 only), created at the first write.
+    bool isColumnarOutputEnabled;
+    std::string columnarFileName;
+    uint64_t columnarParametersHash;
+    uint64_t columnarSeed;
+    ColumnarTimeSeriesWriter* columnarOutput;
+
+public:
+    AgentsDataRecorder(std::string fileName, boost::mpi::communicator* comm);
+    ~AgentsDataRecorder();
+
+    // Adds a column. The recorder takes ownership of the data source. All columns need to be added before the first record.
+    void addDataSource(std::string columnName, repast::TDataSource<int>* dataSource);
+
+    // Also writes the records to a binary columnar file, each write appending one chunk. The hash and seed identify the run in its header.
+    void enableColumnarOutput(std::string fileName, uint64_t parametersHash, uint64_t seed);
+
+    // Scheduled events. Both need to be called by all processes.
+    void record();
+    void write();
+
+    // Starts recording a new run into the passed file, as after construction. Records which were not written are dropped. Needs to be called by all processes.
+    void restart(std::string fileName);
+
+    // Checks the passed termination criteria on each completed record (none if nullptr). Needs to be called by all processes, before the first record.
+    void setTerminationCriteria(TerminationCriteria* criteria){  terminationCriteria = criteria;     }
+
+    // Also keeps all records in memory, for reading them without the files (e.g. by the library API). Needs to be called before the first record.
+    void retainRecords(){                                       isRetainingRecords = true;          }
+
+    // Completes the record in flight and copies the records retained on rank 0 to all processes. Needs to be called by all processes.
+    void shareRetainedRecords();
+
+    /* Getters */
+    int getColumnsCount() const {                               return columnNames.size();          }
+    const std::string& getColumnName(int column) const {        return columnNames[column];         }
+    const std::vector<double>& getRetainedTicks() const {       return retainedTicks;               }
+    const std::vector<long long>& getRetainedValues() const {   return retainedValues;              }
+
+private:
+    void completeReduction();
+
+    // The writer thread's loop, and the writing of the records it has received so far.
+    void runWriterThread();
+    void writeRecordedValues();
+};
@@ -0,0 +1,61 @@
+/* Ensemble_Runner.h */
+#ifndef ENSEMBLE_RUNNER
+#define ENSEMBLE_RUNNER
+
+/**********************
+*   Include files
+**********************/
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/mpi.hpp>
+
+class VirusCellModel;
+
+
+/**********************
+* A job of an ensemble: the name of the directory of its outputs, its random seed and the properties it overrides (e.g. the point of a parameter sweep).
+**********************/
+struct EnsembleJob
+{
+    std::string name;
+    int seed;
+    std::map<std::string, std::string> propertyOverrides;
+};
+
+
+/**********************
+* Ensemble Runner class. Runs many independent replicas of the simulation in one MPI job, instead of one mpirun per replica.
+* The processes are split into groups of equal size, each running one replica at a time on its own communicator. The replicas are jobs
+* numbered from 0, handed out through a counter on process 0 of the world, which the first process of each group increments with a one-sided
+* atomic fetch-and-add whenever its group is free. So a group which finishes early takes the next job straight away, without any group waiting for another.
+*
+* Each job runs with its own random seed and properties, and writes its outputs into a directory of its own, named after the job, in the output directory.
+* A group can reuse its model for all of its jobs, resetting it in between, which saves creating the grid, communicators and buffers for each job.
+* The jobs should be listed with the slowest ones first, when known, so that none of them is left to run on its own at the end.
+**********************/
+class EnsembleRunner
+{
+private:
+    std::string configFile;
+    std::string propsFile;
+    int argc;
+    char** argv;
+
+public:
+    EnsembleRunner(std::string configFile, std::string propsFile, int argc, char** argv);
+
+    // Runs the jobs on the passed count of concurrent groups, each with the passed process grid. Needs to be called by all processes, with the same jobs.
+    // If the model is reused, each group creates its model once and resets it for each further job.
+    void run(boost::mpi::communicator& world, int concurrentReplicas, const std::vector<EnsembleJob>& jobs, std::string outputDirectory,
+             int processesCountXAxis, int processesCountYAxis, bool isNodeAware, bool isModelReused);
+
+    // Creates the jobs of plain replicas (replica_<job>), each with the base seed plus its number.
+    static std::vector<EnsembleJob> createReplicaJobs(int jobsCount, int baseSeed);
+
+private:
+    void runReplica(boost::mpi::communicator& modelComm, const EnsembleJob& job, std::string replicaDirectory, int processesCountXAxis, int processesCountYAxis,
+                    VirusCellModel*& model);
+};
+
+#endif // ENSEMBLE_RUNNER
@@ -76,14 +76,20 @@ public:
             double newVirionReleaseRate, int newCountOfVirionsToRelease, double newVirionReleaseRemainder);
 
     void doStep(repast::SharedContext<VirusCellInteractionAgents>* context, repast::SharedDiscreteSpace<VirusCellInteractionAgents, repast::WrapAroundBorders, repast::SimpleAdder<VirusCellInteractionAgents> >* discreteGridSpace);
+
+    // Advances a copy of the agent in the buffer zone by one step, on the steps when it is not synchronised with the original.
+    void advanceBufferZoneCopy();
     
     // Function which the virion agents can use to infect an epithelial cell agent.
-    void infect(){                  internalState = Infected;     }
+    void infect(){                  changeInternalState(Infected);     }
 
     // Function which the two immune cell agent types can use to eliminate the epithelial cell agent when it is infected.
-    void eliminate(){               internalState = Dead;     externalState = DeadCell;}
+    void eliminate(){               changeInternalState(Dead);     externalState = DeadCell;}
 
 private:
+    // Changes the internal state of the cell and keeps the population counters of the process up-to-date.
+    void changeInternalState(InternalState newInternalState);
+
     void actHealthy(repast::SharedDiscreteSpace<VirusCellInteractionAgents, repast::WrapAroundBorders, repast::SimpleAdder<VirusCellInteractionAgents> >* discreteGridSpace);
     void actInfected(repast::SharedDiscreteSpace<VirusCellInteractionAgents, repast::WrapAroundBorders, repast::SimpleAdder<VirusCellInteractionAgents> >* discreteGridSpace);
     void releaseProgenyVirus();
@@ -0,0 +1,86 @@
+/* Infection_Front.h */
+#ifndef INFECTION_FRONT
+#define INFECTION_FRONT
+
+/**********************
+*   Include files
+**********************/
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/mpi.hpp>
+
+
+/**********************
+* Infection Front Tracker class. Follows how the infection spreads out from each focus, without gathering the grid anywhere.
+* A focus is a fixed anchor site on the grid. Each infected epithelial cell belongs to its nearest focus, with all distances taken the shortest
+* way around the wraparound grid, so they are correct for foci whose infection crosses the edges of the grid.
+* Each process adds up the moments of its own infected cells around each focus (count, sums of the offsets and of the squared distances,
+* and the largest distance), and a sum and a max reduction, in flight together, combine them. From these the centroid, the radius of gyration
+* and the maximal infected radius of each focus follow directly. The front velocity is the least-squares slope of the maximal infected radius over a sliding window of ticks.
+*
+* If no foci are given, a single focus is anchored at the circular mean of the first infected cells, found with one extra reduction of
+* the circular moments of their coordinates.
+**********************/
+class InfectionFrontTracker
+{
+private:
+    MPI_Comm trackerComm;
+
+    int gridSizeX;
+    int gridSizeY;
+
+    // The anchor site of each focus, relative to the origin of the grid.
+    std::vector<std::pair<int, int> > fociSites;
+    bool areFociGiven;
+    bool isFocusAnchored;
+
+    // The infected sites of this process added since the last tick was completed, relative to the origin of the grid.
+    std::vector<std::pair<int, int> > infectedSites;
+
+    // The results of the last completed tick, per focus. The centroids are relative to the origin of the grid.
+    std::vector<int> infectedCounts;
+    std::vector<double> centroidsX;
+    std::vector<double> centroidsY;
+    std::vector<double> radiiOfGyration;
+    std::vector<double> maxInfectedRadii;
+    std::vector<double> frontVelocities;
+
+    // The (tick, maximal infected radius) samples of each focus in the sliding window.
+    int velocityWindow;
+    std::vector<std::deque<std::pair<int, double> > > radiusHistories;
+
+public:
+    // Needs to be called by all processes, with the same foci. An empty list of foci tracks one focus, anchored at the first infections.
+    InfectionFrontTracker(boost::mpi::communicator* comm, int gridSizeX, int gridSizeY, const std::vector<std::pair<int, int> >& foci, int velocityWindow);
+    ~InfectionFrontTracker();
+
+    // Clears the infected sites before the ones of a new tick are added.
+    void clear() {                                          infectedSites.clear();                      }
+    void addInfectedSite(int x, int y) {                    infectedSites.push_back(std::make_pair(x, y)); }
+
+    // Combines the moments of the added sites over all processes and updates the results. Needs to be called by all processes.
+    void completeTick(int tick);
+
+    // Forgets the results and the sliding window, for a new run. A focus which was anchored at the first infections is anchored again.
+    void reset();
+
+    int getFociCount() const {                              return fociSites.size();                    }
+    bool isAnchored() const {                               return isFocusAnchored;                     }
+    int getInfectedCount(int focus) const {                 return infectedCounts[focus];               }
+    double getCentroidX(int focus) const {                  return centroidsX[focus];                   }
+    double getCentroidY(int focus) const {                  return centroidsY[focus];                   }
+    double getRadiusOfGyration(int focus) const {           return radiiOfGyration[focus];              }
+    double getMaxInfectedRadius(int focus) const {          return maxInfectedRadii[focus];             }
+    double getFrontVelocity(int focus) const {              return frontVelocities[focus];              }
+
+    // Parses a comma separated list of sites, each as x:y, e.g. "0:0, 50:-50". Anything which is not a site is ignored.
+    static std::vector<std::pair<int, int> > parseFoci(const std::string& fociList);
+
+private:
+    void anchorFocusAtCircularMean();
+    double getWrappedOffset(int coordinate, int anchorCoordinate, int gridSize) const;
+};
+
+#endif // INFECTION_FRONT
@@ -0,0 +1,79 @@
+/* Plaque_Analysis.h */
+#ifndef PLAQUE_ANALYSIS
+#define PLAQUE_ANALYSIS
+
+/**********************
+*   Include files
+**********************/
+#include <vector>
+#include <boost/mpi.hpp>
+
+#include "Process_Neighbourhood.h"
+
+
+/**********************
+* A site of a plaque on the boundary of a process's section, sent to the neighbouring processes whose sites touch it.
+**********************/
+struct PlaqueBoundarySite
+{
+    int x;                  // The coordinates of the site, relative to the origin of the whole grid.
+    int y;
+    long long label;        // The label of the site's plaque on the process owning it.
+};
+
+
+
+/**********************
+* Plaque Analysis class. Finds the plaques - the connected regions of infected and dead epithelial cells, with the 8 surrounding sites
+* of a site counting as connected - over the whole wraparound grid, and measures their sizes, without gathering the grid anywhere.
+* Each process labels the plaques of its own section with a union-find. The plaques which do not reach the edge of the section are complete,
+* so they are only counted locally. For the others, the labels of the edge sites are exchanged with the neighbouring processes, and the pairs of
+* touching labels are sent to rank 0 together with the sizes of the plaques, where a second union-find merges them into the plaques of the grid.
+* The results are only available on rank 0.
+**********************/
+class PlaqueAnalysis
+{
+private:
+    MPI_Comm analysisComm;
+    int rank;
+    ProcessNeighbourhood* processNeighbourhood;
+
+    int gridSizeX;
+    int gridSizeY;
+    int localStartX;
+    int localStartY;
+    int localSizeX;
+    int localSizeY;
+
+    // The union-find forest of the local sites. Sites which are not part of a plaque are their own parents and are never joined.
+    std::vector<int> siteParents;
+
+    std::vector<std::vector<PlaqueBoundarySite> > outgoingBoundarySites;
+    std::vector<PlaqueBoundarySite> incomingBoundarySites;
+
+    // The results of the last analysis (rank 0 only). Bin b of the size distribution counts the plaques with 2^b to 2^(b+1) - 1 sites.
+    int plaqueCount;
+    int largestPlaqueArea;
+    std::vector<int> plaqueSizeDistribution;
+
+public:
+    // Needs to be called by all processes, each passing the position of its section in the grid.
+    PlaqueAnalysis(boost::mpi::communicator* comm, ProcessNeighbourhood* theProcessNeighbourhood, int gridSizeX, int gridSizeY,
+                   int localStartX, int localStartY, int localSizeX, int localSizeY);
+    ~PlaqueAnalysis();
+
+    // Finds the plaques, given whether each local site (in row-major order) is part of one. Needs to be called by all processes.
+    void analyse(const std::vector<unsigned char>& isPlaqueSite);
+
+    int getPlaqueCount() const {                            return plaqueCount;                         }
+    int getLargestPlaqueArea() const {                      return largestPlaqueArea;                   }
+    int getSizeBinsCount() const {                          return plaqueSizeDistribution.size();       }
+    int getPlaqueCountInSizeBin(int bin) const {            return plaqueSizeDistribution[bin];         }
+
+private:
+    int findRoot(int site);
+    bool isLocalSite(int x, int y) const;
+    int getSizeBin(long long plaqueSize) const;
+};
+
+#endif // PLAQUE_ANALYSIS
@@ -0,0 +1,51 @@
+/* Population_Counters.h */
+#ifndef POPULATION_COUNTERS
+#define POPULATION_COUNTERS
+
+
+/**********************
+* Population Counters class. Holds the counts of the agents which are local to this process, by agent type and, for the epithelial cells, by internal state.
+* The counts are kept up-to-date on every creation, removal, migration and epithelial cell state change, so the data sources can read them
+* without scanning the agents. Only the original agents are counted - the copies in the buffer zones belong to the count of their own process.
+**********************/
+class PopulationCounters
+{
+private:
+    static PopulationCounters* theInstance;
+
+    // The rank of this process. Agents whose current rank differs from it are copies of agents on other processes.
+    int rank;
+
+    // The count of local epithelial cells in each internal state (indexed by EpithelialCellAgent::InternalState).
+    int epithelialCellsCountByState[3];
+
+    // The count of local mobile agents of each agent type (indexed by agent type, the epithelial cells at index 0 are counted by state instead).
+    int mobileAgentsCountByType[4];
+
+    PopulationCounters();
+
+public:
+    static PopulationCounters* instance();
+
+    // Sets all counts to 0. Needs to be called before the agents of a new model are created.
+    void reset(int processRank);
+
+    // Called by the epithelial cells when they are created and when their internal state changes. Ignored for the copies in the buffer zones.
+    void epithelialCellAdded(int currentRank, int internalState);
+    void epithelialCellStateChanged(int currentRank, int oldInternalState, int newInternalState);
+
+    // Called when a virion or immune cell agent is created on, or moved to this process, and when it is removed from, or moved off this process.
+    void mobileAgentAdded(int agentType){               ++mobileAgentsCountByType[agentType];    }
+    void mobileAgentRemoved(int agentType){             --mobileAgentsCountByType[agentType];    }
+
+    /* Getters */
+    int getAliveEpithelialCellsCount() const;
+    int getInfectedEpithelialCellsCount() const;
+    int getDeadEpithelialCellsCount() const;
+    int getVirionsCount() const {                       return mobileAgentsCountByType[1];      }
+    int getInnateImmuneCellsCount() const {             return mobileAgentsCountByType[2];      }
+    int getSpecialisedImmuneCellsCount() const {        return mobileAgentsCountByType[3];      }
+    int getTotalAgentsCount() const;
+};
+
+#endif // POPULATION_COUNTERS
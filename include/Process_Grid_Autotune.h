@@ -0,0 +1,37 @@
+/* Process_Grid_Autotune.h */
+#ifndef PROCESS_GRID_AUTOTUNE
+#define PROCESS_GRID_AUTOTUNE
+
+/**********************
+*   Include files
+**********************/
+#include <string>
+#include <vector>
+#include <boost/mpi.hpp>
+
+
+/**********************
+* Process Grid Autotune class. Chooses the shape of the process grid for the count of processes the simulation runs on.
+* Every factorisation of the process count which splits the grid evenly is tried with a short calibration run of the model, and the one with the
+* shortest step time wins. The timings of all candidates and the choice are written to process_grid_autotune.csv in the output directory.
+**********************/
+class ProcessGridAutotune
+{
+private:
+    std::string configFile;
+    std::string propsFile;
+    int argc;
+    char** argv;
+
+public:
+    ProcessGridAutotune(std::string configFile, std::string propsFile, int argc, char** argv);
+
+    // Runs the calibration on each candidate process grid and returns the fastest one. Needs to be called by all processes.
+    void findFastestProcessGrid(boost::mpi::communicator& world, int gridDimension, bool isNodeAware, int calibrationSteps, std::string outputDirectory,
+                                int& bestCountXAxis, int& bestCountYAxis);
+
+private:
+    void findCandidateProcessGrids(int processesCount, int gridDimension, std::vector<int>& candidateCountsXAxis) const;
+};
+
+#endif // PROCESS_GRID_AUTOTUNE
@@ -0,0 +1,48 @@
+/* Process_Grid_Mapping.h */
+#ifndef PROCESS_GRID_MAPPING
+#define PROCESS_GRID_MAPPING
+
+/**********************
+*   Include files
+**********************/
+#include <vector>
+#include <mpi.h>
+
+
+/**********************
+* Process Grid Mapping class. Decides which section of the wraparound process grid each process handles. Repast hands the sections out in rank order
+* (row-major over the grid), so the mapping is applied by creating a communicator in which the rank of each process is the index of its section.
+* The node-aware mapping splits the grid into equal blocks, one per node, so that most neighbouring sections are handled by processes on the same node.
+**********************/
+class ProcessGridMapping
+{
+private:
+    int processesCountXAxis;
+    int processesCountYAxis;
+
+    // The index of the node each process of the passed communicator is on. The nodes are ordered by their lowest rank.
+    std::vector<int> nodeOfRank;
+    std::vector<int> processesPerNode;
+
+public:
+    ProcessGridMapping(MPI_Comm comm, int processesCountXAxis, int processesCountYAxis);
+
+    // Creates the communicator whose ranks are the sections of the grid the processes are to handle, mapping the sections onto the nodes in blocks.
+    // If the grid cannot be split into equal blocks for the nodes, the sections are left in rank order. Needs to be called by all processes.
+    MPI_Comm createNodeAwareCommunicator(MPI_Comm comm, int& blockSizeX, int& blockSizeY) const;
+
+    // Counts the pairs of neighbouring sections (including the diagonal and wraparound neighbours) which are handled on different nodes,
+    // given the node of the process handling each section.
+    int countInterNodeEdges(const std::vector<int>& nodeOfSection) const;
+
+    const std::vector<int>& getNodeOfRank() const {         return nodeOfRank;  }
+
+    // Creates the communicator the model is to run on for the passed process grid, with the node-aware mapping if requested, 
+    // and logs the inter-node neighbour pairs of the mapping if requested. The caller owns the returned communicator.
+    static MPI_Comm createModelCommunicator(MPI_Comm comm, int processesCountXAxis, int processesCountYAxis, bool isNodeAware, bool isMappingLogged);
+
+private:
+    bool findNodeBlockShape(int& blockSizeX, int& blockSizeY) const;
+};
+
+#endif // PROCESS_GRID_MAPPING
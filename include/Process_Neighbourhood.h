@@ -0,0 +1,387 @@
+/* Process_Neighbourhood.h */
+#ifndef PROCESS_NEIGHBOURHOOD
+#define PROCESS_NEIGHBOURHOOD
+
+/**********************
+*   Include files
+**********************/
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <mpi.h>
+#include <boost/mpi.hpp>
+
+
+/**********************
+* Process Neighbourhood class. Builds the Cartesian topology of the wraparound process grid once at startup, together with a distributed graph
+* communicator which connects each process only to its (at most 8) Moore neighbours in that grid.
+* All of the model's own per-tick cross-process traffic goes through the neighbourhood collectives of the graph communicator,
+* so that the cost of an exchange depends on the count of neighbours rather than on the total count of processes.
+* The blocking exchange can also pass the records for the neighbours on the same node through shared memory (see enableSharedMemoryExchange).
+**********************/
+class ProcessNeighbourhood
+{
+private:
+    // The periodic Cartesian communicator of the process grid. Created without reordering, so its ranks are the same as the ranks of the
+    // communicator the grid projection is created with, and the coordinates of each rank match the section of the grid it handles.
+    MPI_Comm cartesianComm;
+
+    // The distributed graph communicator connecting each process to its neighbours only.
+    MPI_Comm neighbourhoodComm;
+
+    int processDims[2];
+    int processCoords[2];
+
+    // The ranks of the neighbouring processes, in the order used by the neighbourhood collectives. Each rank appears only once,
+    // even if it neighbours this process from more than one direction (which happens when the grid has less than 3 processes on an axis).
+    std::vector<int> neighbourRanks;
+
+    // The index of the neighbour in each of the 8 directions, indexed by [dx + 1][dy + 1], or -1 where the neighbour is this process itself.
+    int neighbourIndexInDirection[3][3];
+
+    // Counts, displacements and buffers of the exchanges. They are kept between ticks, so that no allocation is needed once they have grown
+    // to the size of the per-tick traffic.
+    std::vector<int> sendByteCounts;
+    std::vector<int> sendByteDispls;
+    std::vector<int> recvByteCounts;
+    std::vector<int> recvByteDispls;
+    std::vector<char> sendBuffer;
+    std::vector<char> recvBuffer;
+
+    // The shared memory path of the blocking exchange, used for the neighbours on the same node when enabled.
+    // Each process has a segment of a shared memory window holding two mailboxes per neighbour, used on alternate exchanges. A mailbox is a header
+    // of two ints (the exchange number, written last, and the count of records) followed by the records. The neighbours on the same node
+    // read their mailboxes straight from this process's segment, so the only handshake is waiting for the exchange number to appear.
+    // The records which do not fit in a mailbox are sent as a message over the Cartesian communicator instead, and the count of -1 in the mailbox
+    // tells the neighbour to receive them from there.
+    bool isSharedMemoryEnabled;
+    MPI_Comm nodeComm;
+    MPI_Win sharedWindow;
+    int mailboxBytes;
+    int sharedExchangeCount;
+    char* ownSegment;
+    std::vector<char*> neighbourSegments;                   // The segment of each neighbour, or nullptr if it is on another node.
+    std::vector<int> indexInNeighbourList;                  // The index of this process in the list of neighbours of each neighbour.
+    std::vector<MPI_Request> overflowRequests;
+
+    // The neighbours on other nodes keep exchanging messages, over a graph communicator connecting only them.
+    MPI_Comm remoteNeighbourhoodComm;
+    std::vector<int> remoteNeighbourIndices;
+
+    // State of the non-blocking exchange. It uses blocks of a fixed size per neighbour, so that it can be posted without exchanging the counts first.
+    MPI_Request exchangeRequest;
+    bool isExchangeInFlight;
+    int blockBytes;
+
+public:
+    ProcessNeighbourhood(boost::mpi::communicator* comm, int processesCountXAxis, int processesCountYAxis);
+    ~ProcessNeighbourhood();
+
+    int getNeighbourCount() const {                         return neighbourRanks.size();      }
+    int getNeighbourRank(int neighbourIndex) const {        return neighbourRanks[neighbourIndex]; }
+    int getNeighbourIndex(int rank) const;
+    int getNeighbourIndexInDirection(int dx, int dy) const {    return neighbourIndexInDirection[dx + 1][dy + 1]; }
+
+    int getProcessCoordinate(int axis) const {              return processCoords[axis];         }
+    int getProcessGridSize(int axis) const {                return processDims[axis];           }
+    void getProcessCoordinatesOfRank(int rank, int* coords) const;
+
+    MPI_Comm getCartesianCommunicator() const {             return cartesianComm;               }
+    MPI_Comm getNeighbourhoodCommunicator() const {         return neighbourhoodComm;           }
+
+    // Makes the blocking exchange use shared memory for the neighbours on the same node. The mailboxes hold maxBytesPerNeighbour bytes of records,
+    // and more records than that are sent as messages. Needs to be called by all processes, as the shared memory window is allocated collectively.
+    void enableSharedMemoryExchange(int maxBytesPerNeighbour);
+    bool isOnSameNode(int neighbourIndex) const {           return isSharedMemoryEnabled && neighbourSegments[neighbourIndex] != nullptr; }
+
+    // Sends recordsToSend[i] to the i-th neighbour and receives the records all neighbours have sent to this process.
+    // The records need to be plain data structs, as they are sent as raw bytes.
+    template<typename Record>
+    void exchange(const std::vector<std::vector<Record> >& recordsToSend, std::vector<Record>& receivedRecords);
+
+    // Non-blocking version of exchange. Posts the records to the neighbours and returns straight away. Each neighbour can be sent at most
+    // maxRecordsPerNeighbour records, and more abort the run. The received records are only available after completeExchange has been called.
+    template<typename Record>
+    void beginExchange(const std::vector<std::vector<Record> >& recordsToSend, int maxRecordsPerNeighbour);
+
+    // Checks whether the posted exchange has completed, without waiting for it. Calling it also lets MPI progress the exchange.
+    bool testExchange();
+
+    // Waits for the posted exchange to complete and returns the records the neighbours have sent to this process.
+    template<typename Record>
+    void completeExchange(std::vector<Record>& receivedRecords);
+
+private:
+    void findNeighbourRanks(const int* coords, std::vector<int>& ranks, int directionIndices[3][3]) const;
+    void exchangeBytes(MPI_Comm comm, int commNeighbourCount);
+    char* getMailbox(char* segment, int neighbourIndex, int parity) const {     return segment + (2 * neighbourIndex + parity) * mailboxBytes; }
+
+    template<typename Record>
+    void exchangeThroughSharedMemory(const std::vector<std::vector<Record> >& recordsToSend, std::vector<Record>& receivedRecords);
+};
+
+
+
+/**********************
+*   ProcessNeighbourhood::exchange - Sends a (possibly empty) set of records to each neighbour. First the byte counts are exchanged
+*   with the neighbours only, then the records themselves with a single sparse all-to-all over the neighbourhood.
+**********************/
+template<typename Record>
+void ProcessNeighbourhood::exchange(const std::vector<std::vector<Record> >& recordsToSend, std::vector<Record>& receivedRecords)
+{
+    if( isSharedMemoryEnabled )
+    {
+        exchangeThroughSharedMemory(recordsToSend, receivedRecords);
+        return;
+    }
+
+    int neighbourCount = neighbourRanks.size();
+
+    // Pack the records for all neighbours in one contiguous buffer.
+    int totalSendBytes = 0;
+    for( int i = 0; i < neighbourCount; ++i )
+    {
+        sendByteCounts[i] = recordsToSend[i].size() * sizeof(Record);
+        sendByteDispls[i] = totalSendBytes;
+        totalSendBytes += sendByteCounts[i];
+    }
+
+    if( sendBuffer.size() < (size_t)totalSendBytes )
+    {
+        sendBuffer.resize(totalSendBytes);
+    }
+
+    for( int i = 0; i < neighbourCount; ++i )
+    {
+        if( sendByteCounts[i] > 0 )
+        {
+            std::memcpy(&sendBuffer[sendByteDispls[i]], recordsToSend[i].data(), sendByteCounts[i]);
+        }
+    }
+
+    exchangeBytes(neighbourhoodComm, neighbourCount);
+
+    // Unpack the received records.
+    int totalRecvBytes = 0;
+    for( int i = 0; i < neighbourCount; ++i )
+    {
+        totalRecvBytes += recvByteCounts[i];
+    }
+
+    receivedRecords.resize(totalRecvBytes / sizeof(Record));
+    if( totalRecvBytes > 0 )
+    {
+        std::memcpy(receivedRecords.data(), recvBuffer.data(), totalRecvBytes);
+    }
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::exchangeThroughSharedMemory - The blocking exchange when the shared memory path is enabled. The records for the neighbours
+*   on the same node are written to this process's mailboxes for them, and read straight from the neighbours' mailboxes for this process.
+*   The records for the neighbours on other nodes are sent as messages, while the neighbours on the same node catch up.
+**********************/
+template<typename Record>
+void ProcessNeighbourhood::exchangeThroughSharedMemory(const std::vector<std::vector<Record> >& recordsToSend, std::vector<Record>& receivedRecords)
+{
+    int neighbourCount = neighbourRanks.size();
+    int maxRecordsPerMailbox = (mailboxBytes - 2 * sizeof(int)) / sizeof(Record);
+
+    // The two mailboxes per neighbour are used on alternate exchanges. A neighbour can only start writing to a mailbox again after it has
+    // completed the exchange following the one it was last used in, for which it needs this process's records, sent after this process had
+    // finished reading that mailbox. So a single exchange number per mailbox is all the handshake needed.
+    ++sharedExchangeCount;
+    int parity = sharedExchangeCount % 2;
+
+    for( int i = 0; i < neighbourCount; ++i )
+    {
+        if( neighbourSegments[i] == nullptr )
+        {
+            continue;
+        }
+
+        int recordsCount = recordsToSend[i].size();
+        if( recordsCount > maxRecordsPerMailbox )
+        {
+            // The records stay in place until the send has completed at the end of the exchange.
+            overflowRequests.push_back(MPI_REQUEST_NULL);
+            MPI_Isend(recordsToSend[i].data(), recordsCount * sizeof(Record), MPI_BYTE, neighbourRanks[i], 0, cartesianComm, &overflowRequests.back());
+            recordsCount = -1;
+        }
+
+        char* mailbox = getMailbox(ownSegment, i, parity);
+        std::memcpy(mailbox + sizeof(int), &recordsCount, sizeof(int));
+        if( recordsCount > 0 )
+        {
+            std::memcpy(mailbox + 2 * sizeof(int), recordsToSend[i].data(), recordsCount * sizeof(Record));
+        }
+
+        // Make the records visible before the exchange number which tells the neighbour they are there.
+        MPI_Win_sync(sharedWindow);
+        *(volatile int*)mailbox = sharedExchangeCount;
+    }
+    MPI_Win_sync(sharedWindow);
+
+    // Exchange the records with the neighbours on other nodes as messages.
+    int remoteNeighbourCount = remoteNeighbourIndices.size();
+    int totalSendBytes = 0;
+    for( int r = 0; r < remoteNeighbourCount; ++r )
+    {
+        sendByteCounts[r] = recordsToSend[remoteNeighbourIndices[r]].size() * sizeof(Record);
+        sendByteDispls[r] = totalSendBytes;
+        totalSendBytes += sendByteCounts[r];
+    }
+
+    if( sendBuffer.size() < (size_t)totalSendBytes )
+    {
+        sendBuffer.resize(totalSendBytes);
+    }
+
+    for( int r = 0; r < remoteNeighbourCount; ++r )
+    {
+        if( sendByteCounts[r] > 0 )
+        {
+            std::memcpy(&sendBuffer[sendByteDispls[r]], recordsToSend[remoteNeighbourIndices[r]].data(), sendByteCounts[r]);
+        }
+    }
+
+    exchangeBytes(remoteNeighbourhoodComm, remoteNeighbourCount);
+
+    int totalRecvBytes = 0;
+    for( int r = 0; r < remoteNeighbourCount; ++r )
+    {
+        totalRecvBytes += recvByteCounts[r];
+    }
+
+    receivedRecords.resize(totalRecvBytes / sizeof(Record));
+    if( totalRecvBytes > 0 )
+    {
+        std::memcpy(receivedRecords.data(), recvBuffer.data(), totalRecvBytes);
+    }
+
+    // Read the records of the neighbours on the same node, waiting for each to have written them.
+    for( int i = 0; i < neighbourCount; ++i )
+    {
+        if( neighbourSegments[i] == nullptr )
+        {
+            continue;
+        }
+
+        const char* mailbox = getMailbox(neighbourSegments[i], indexInNeighbourList[i], parity);
+        while( *(const volatile int*)mailbox != sharedExchangeCount )
+        {
+            MPI_Win_sync(sharedWindow);
+        }
+        MPI_Win_sync(sharedWindow);
+
+        int recordsCount;
+        std::memcpy(&recordsCount, mailbox + sizeof(int), sizeof(int));
+
+        // The records which did not fit in the mailbox come as a message. The messages of a pair cannot overtake each other, so the first one
+        // is the one for this exchange.
+        size_t firstRecord = receivedRecords.size();
+        if( recordsCount < 0 )
+        {
+            MPI_Status status;
+            int overflowBytes;
+            MPI_Probe(neighbourRanks[i], 0, cartesianComm, &status);
+            MPI_Get_count(&status, MPI_BYTE, &overflowBytes);
+
+            receivedRecords.resize(firstRecord + overflowBytes / sizeof(Record));
+            MPI_Recv(&receivedRecords[firstRecord], overflowBytes, MPI_BYTE, neighbourRanks[i], 0, cartesianComm, MPI_STATUS_IGNORE);
+            continue;
+        }
+
+        receivedRecords.resize(firstRecord + recordsCount);
+        if( recordsCount > 0 )
+        {
+            std::memcpy(&receivedRecords[firstRecord], mailbox + 2 * sizeof(int), recordsCount * sizeof(Record));
+        }
+    }
+
+    if( !overflowRequests.empty() )
+    {
+        MPI_Waitall(overflowRequests.size(), overflowRequests.data(), MPI_STATUSES_IGNORE);
+        overflowRequests.clear();
+    }
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::beginExchange - Posts a non-blocking exchange of records with the neighbours. Each neighbour gets a block of a
+*   fixed size holding the count of records followed by the records, so the exchange is a single non-blocking all-to-all over the neighbourhood.
+**********************/
+template<typename Record>
+void ProcessNeighbourhood::beginExchange(const std::vector<std::vector<Record> >& recordsToSend, int maxRecordsPerNeighbour)
+{
+    int neighbourCount = neighbourRanks.size();
+    blockBytes = sizeof(int) + maxRecordsPerNeighbour * sizeof(Record);
+
+    if( sendBuffer.size() < (size_t)(blockBytes * neighbourCount) )
+    {
+        sendBuffer.resize(blockBytes * neighbourCount);
+    }
+    if( recvBuffer.size() < (size_t)(blockBytes * neighbourCount) )
+    {
+        recvBuffer.resize(blockBytes * neighbourCount);
+    }
+
+    for( int i = 0; i < neighbourCount; ++i )
+    {
+        int recordsCount = recordsToSend[i].size();
+        if( recordsCount > maxRecordsPerNeighbour )
+        {
+            // The records are requests the neighbour has to carry out, so none of them can be dropped.
+            std::cout<<"More records than the block size allows were passed to ProcessNeighbourhood::beginExchange ("<<recordsCount<<" for at most "
+                <<maxRecordsPerNeighbour<<")! Aborting, as the records cannot all be sent."<<std::endl;
+            MPI_Abort(cartesianComm, 1);
+        }
+
+        char* block = &sendBuffer[i * blockBytes];
+        std::memcpy(block, &recordsCount, sizeof(int));
+        if( recordsCount > 0 )
+        {
+            std::memcpy(block + sizeof(int), recordsToSend[i].data(), recordsCount * sizeof(Record));
+        }
+    }
+
+    MPI_Ineighbor_alltoall(sendBuffer.data(), blockBytes, MPI_BYTE, recvBuffer.data(), blockBytes, MPI_BYTE, neighbourhoodComm, &exchangeRequest);
+    isExchangeInFlight = true;
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::completeExchange - Waits for the posted exchange to complete and unpacks the records received from all neighbours.
+**********************/
+template<typename Record>
+void ProcessNeighbourhood::completeExchange(std::vector<Record>& receivedRecords)
+{
+    receivedRecords.clear();
+    if( !isExchangeInFlight )
+    {
+        return;
+    }
+
+    MPI_Wait(&exchangeRequest, MPI_STATUS_IGNORE);
+    isExchangeInFlight = false;
+
+    int neighbourCount = neighbourRanks.size();
+    for( int i = 0; i < neighbourCount; ++i )
+    {
+        const char* block = &recvBuffer[i * blockBytes];
+        int recordsCount;
+        std::memcpy(&recordsCount, block, sizeof(int));
+
+        size_t firstRecord = receivedRecords.size();
+        receivedRecords.resize(firstRecord + recordsCount);
+        if( recordsCount > 0 )
+        {
+            std::memcpy(&receivedRecords[firstRecord], block + sizeof(int), recordsCount * sizeof(Record));
+        }
+    }
+}
+
+#endif // PROCESS_NEIGHBOURHOOD
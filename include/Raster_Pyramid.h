@@ -0,0 +1,72 @@
+/* Raster_Pyramid.h */
+#ifndef RASTER_PYRAMID
+#define RASTER_PYRAMID
+
+/**********************
+*   Include files
+**********************/
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/mpi.hpp>
+
+
+/**********************
+* Raster Pyramid class. Summarises the grid in square blocks of sites on every tick it is asked to, and writes the summaries as a small compressed
+* frame, so the course of the infection can be followed at every tick for a tiny fraction of the size of the full snapshots.
+* Each process sums its own section into the blocks, the sums are added up onto rank 0 in one reduction, and rank 0 builds the coarser levels
+* of the pyramid by merging 2x2 blocks of the level below, until a single block covers the whole grid.
+*
+* The file starts with a header of int32 values in native byte order: "VCRP", version, grid size on the X and Y axes, block size, count of channels
+* and the density scale. Each frame then holds the tick and the count of levels, and for each level its size in blocks on the X and Y axes, followed by
+* each channel as a byte count and run-length encoded (run length, value) byte pairs, in row-major order (X major). The channels are the fractions of
+* infected and of dead epithelial cells (255 = all cells), and the mean count of virions and of immune cells per site (density scale = 1 per site).
+**********************/
+class RasterPyramid
+{
+public:
+    enum Channel{ InfectedCellsChannel, DeadCellsChannel, VirionsChannel, ImmuneCellsChannel, ChannelsCount };
+
+private:
+    MPI_Comm rasterComm;
+    int rank;
+
+    int blockSize;
+    int blocksCountX;
+    int blocksCountY;
+    int localStartX;
+    int localStartY;
+
+    // The sums of each channel over each block of the grid, indexed [channel][block X][block Y]. Each process only fills the blocks of its section.
+    std::vector<unsigned int> localBlockSums;
+    std::vector<unsigned int> gridBlockSums;
+
+    std::string outputFileName;
+    std::ofstream output;
+
+public:
+    // Needs to be called by all processes, each passing the position of its section in the grid. The block size is reduced if needed,
+    // so that the blocks tile every section.
+    RasterPyramid(boost::mpi::communicator* comm, int gridSizeX, int gridSizeY, int localStartX, int localStartY, int localSizeX, int localSizeY,
+                  int requestedBlockSize, std::string fileName);
+    ~RasterPyramid();
+
+    // Clears the sums of this process before the sites of a new frame are added.
+    void clear();
+
+    // Writes the frames from now on into the passed file, created at the next write.
+    void restart(std::string fileName);
+
+    // Adds 1 to the passed channel of the block containing the site at the passed coordinates in this process's section.
+    void addToSite(int localX, int localY, Channel channel){
+        localBlockSums[(channel * blocksCountX + (localStartX + localX) / blockSize) * blocksCountY + (localStartY + localY) / blockSize] += 1;
+    }
+
+    // Sums the blocks over the processes and writes the frame of the passed tick from rank 0. Needs to be called by all processes.
+    void writeFrame(int tick);
+
+private:
+    void appendLevel(std::string& frame, const std::vector<unsigned int>& levelSums, const std::vector<unsigned int>& levelSites, int levelSizeX, int levelSizeY);
+};
+
+#endif // RASTER_PYRAMID
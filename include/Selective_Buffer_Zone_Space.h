@@ -0,0 +1,113 @@
+/* Selective_Buffer_Zone_Space.h */
+#ifndef SELECTIVE_BUFFER_ZONE_SPACE
+#define SELECTIVE_BUFFER_ZONE_SPACE
+
+/**********************
+*   Include files
+**********************/
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <boost/mpi.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+#include "repast_hpc/AgentId.h"
+#include "repast_hpc/SharedDiscreteSpace.h"
+#include "repast_hpc/Utilities.h"
+
+
+/**********************
+* Selective Buffer Zone Space class. A shared discrete space which only copies the agents of the chosen types into the buffer zones of
+* the neighbouring processes. The agents of the other types are still moved to a new process when they cross into its section of the grid,
+* but no other process keeps a copy of them, so they add no traffic to the projection and state synchronisations.
+**********************/
+template<typename T, typename GPTransformer, typename Adder>
+class SelectiveBufferZoneSpace : public repast::SharedDiscreteSpace<T, GPTransformer, Adder>
+{
+private:
+    std::set<int> replicatedAgentTypes;
+
+public:
+    SelectiveBufferZoneSpace(std::string name, repast::GridDimensions gridDims, std::vector<int> processDims, int buffer,
+                             boost::mpi::communicator* communicator, const std::set<int>& replicatedTypes);
+    virtual ~SelectiveBufferZoneSpace() {}
+
+    bool isReplicatedAgentType(int agentType) const {       return replicatedAgentTypes.count(agentType) > 0; }
+
+    // Called by the shared context when synchronising the projection, to find which local agents need a copy on which process.
+    virtual void getAgentsToPush(std::set<repast::AgentId>& agentsToTest, std::map<int, std::set<repast::AgentId> >& agentsToPush);
+
+    // Parses a comma separated list of agent types, as given in the properties file.
+    static std::set<int> parseAgentTypes(const std::string& agentTypesList);
+};
+
+
+
+/**********************
+*   SelectiveBufferZoneSpace::SelectiveBufferZoneSpace - Constructor. Same as for the shared discrete space, with the set of the agent types
+*   which are to be copied into the buffer zones.
+**********************/
+template<typename T, typename GPTransformer, typename Adder>
+SelectiveBufferZoneSpace<T, GPTransformer, Adder>::SelectiveBufferZoneSpace(std::string name, repast::GridDimensions gridDims, std::vector<int> processDims,
+                                                                              int buffer, boost::mpi::communicator* communicator, const std::set<int>& replicatedTypes):
+repast::SharedDiscreteSpace<T, GPTransformer, Adder>(name, gridDims, processDims, buffer, communicator),
+replicatedAgentTypes(replicatedTypes)
+{
+}
+
+
+
+/**********************
+*   SelectiveBufferZoneSpace::getAgentsToPush - Finds the agents in the buffer zones as the shared discrete space does,
+*   then drops the agents of the types which are not replicated.
+**********************/
+template<typename T, typename GPTransformer, typename Adder>
+void SelectiveBufferZoneSpace<T, GPTransformer, Adder>::getAgentsToPush(std::set<repast::AgentId>& agentsToTest, std::map<int, std::set<repast::AgentId> >& agentsToPush)
+{
+    repast::SharedDiscreteSpace<T, GPTransformer, Adder>::getAgentsToPush(agentsToTest, agentsToPush);
+
+    typename std::map<int, std::set<repast::AgentId> >::iterator processIter;
+    for( processIter = agentsToPush.begin(); processIter != agentsToPush.end(); ++processIter )
+    {
+        std::set<repast::AgentId>::iterator agentIter = processIter->second.begin();
+        while( agentIter != processIter->second.end() )
+        {
+            if( isReplicatedAgentType(agentIter->agentType()) )
+            {
+                ++agentIter;
+            }
+            else
+            {
+                processIter->second.erase(agentIter++);
+            }
+        }
+    }
+}
+
+
+
+/**********************
+*   SelectiveBufferZoneSpace::parseAgentTypes - Parses a comma separated list of agent types, e.g. "0" or "0,2".
+**********************/
+template<typename T, typename GPTransformer, typename Adder>
+std::set<int> SelectiveBufferZoneSpace<T, GPTransformer, Adder>::parseAgentTypes(const std::string& agentTypesList)
+{
+    std::set<int> agentTypes;
+
+    std::stringstream listStream(agentTypesList);
+    std::string agentType;
+    while( std::getline(listStream, agentType, ',') )
+    {
+        boost::algorithm::trim(agentType);
+        if( !agentType.empty() )
+        {
+            agentTypes.insert(repast::strToInt(agentType));
+        }
+    }
+
+    return agentTypes;
+}
+
+#endif // SELECTIVE_BUFFER_ZONE_SPACE
@@ -0,0 +1,89 @@
+/* Simulation_Checkpoint.h */
+#ifndef SIMULATION_CHECKPOINT
+#define SIMULATION_CHECKPOINT
+
+/**********************
+*   Include files
+**********************/
+#include <string>
+#include <vector>
+#include <boost/mpi.hpp>
+
+#include "Agent_Synchronisation_Package_Pattern.h"
+
+
+// The room kept for the text form of a process's random number engine (the state of a mt19937 takes under 7000 characters).
+const int checkpointRandomStateBytes = 8192;
+
+
+/**********************
+* A local agent in a checkpoint: its package, as used to move it across processes, and its site, relative to the origin of the grid.
+**********************/
+struct CheckpointAgentRecord
+{
+    int x;
+    int y;
+    VirusCellInteractionAgentPackage package;
+};
+
+
+/**********************
+* The state of a process in a checkpoint, other than its agents.
+**********************/
+struct CheckpointProcessState
+{
+    int currVirionAgentId;
+    int currInnateImmuneCellAgentId;
+    int currSpecialisedImmuneCellAgentId;
+    int executedStepsCount;
+    int countVirsWhichManagedToInfectACell;
+    char randomEngineState[checkpointRandomStateBytes];
+};
+
+
+/**********************
+* Simulation Checkpoint class. Writes the full state of the simulation at a tick into a single file through MPI-IO, and reads it back on restart.
+* The file starts with a header of 64 bytes (int32 values in native byte order: "VCCP", version, tick, grid size on the X and Y axes, count of processes,
+* bytes per agent record and per process state, then the total count of agent records as an int64 and the length of the parameters text as an int32).
+* The parameters of the checkpointed run follow as sorted key=value lines, then the state of each process in rank order, and then the agent records
+* of all processes, each process writing its own at the offset given by a prefix sum of the counts.
+*
+* On restart, each process reads an equal share of the agent records and sends each to the process owning its site, so the checkpoint can be
+* read on any decomposition of the same grid. A process takes the state of the process with the same rank. A process whose rank did not exist before
+* gets no state, and the model reseeds its random number engine from the seed and the rank, so no two processes draw the same random numbers.
+* A restart on a different count of processes is therefore not reproducible bit for bit. The agent ids of the mobile agents stay unique, as the ids
+* are made unique by the rank which created the agent, and a process whose rank did not exist before has no agents created by it.
+**********************/
+class SimulationCheckpoint
+{
+private:
+    MPI_Comm checkpointComm;
+    int rank;
+    int processesCount;
+
+    int gridSizeX;
+    int gridSizeY;
+
+    // The index of the section containing each coordinate on the X and Y axes, and the rank owning each section, indexed [section X][section Y].
+    std::vector<int> sectionIndexOfX;
+    std::vector<int> sectionIndexOfY;
+    int sectionsCountY;
+    std::vector<int> sectionOwnerRanks;
+
+public:
+    // Needs to be called by all processes, each passing the position of its section in the grid.
+    SimulationCheckpoint(boost::mpi::communicator* comm, int gridSizeX, int gridSizeY, int localStartX, int localStartY, int localSizeX, int localSizeY);
+    ~SimulationCheckpoint();
+
+    // Writes the checkpoint of the passed tick, replacing the file only once it is complete. Needs to be called by all processes.
+    bool write(std::string fileName, int tick, const std::string& parametersText, const CheckpointProcessState& processState, 
+               const std::vector<CheckpointAgentRecord>& agentRecords);
+
+    // Reads a checkpoint, returning the agents whose sites are in this process's section. Needs to be called by all processes.
+    bool read(std::string fileName, int& tick, std::string& parametersText, CheckpointProcessState& processState, std::vector<CheckpointAgentRecord>& agentRecords);
+
+private:
+    int getOwnerRank(int x, int y) const {                  return sectionOwnerRanks[sectionIndexOfX[x] * sectionsCountY + sectionIndexOfY[y]]; }
+};
+
+#endif // SIMULATION_CHECKPOINT
@@ -0,0 +1,57 @@
+/* Spatial_Snapshot.h */
+#ifndef SPATIAL_SNAPSHOT
+#define SPATIAL_SNAPSHOT
+
+/**********************
+*   Include files
+**********************/
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/mpi.hpp>
+
+
+/**********************
+* Spatial Snapshot Writer class. Writes the state of every site of the grid at a tick into one shared file, with each process writing
+* its own section through a subarray file view and collective MPI-IO writes, so no process ever holds more than its own section.
+*
+* The file starts with a 64 byte header of int32 values in native byte order: "VCSS", version, tick, grid size on the X and Y axes,
+* count of epithelial cells per state byte (1 or 2) and count of layers (4), with the rest left as 0. Four layers follow, each covering
+* the whole grid in row-major order (X major, as the agent ids):
+*   1. The epithelial cell states, the internal state in the low 2 bits and the external state in the next 2 bits. When every section
+*      has an even size and start on the Y axis, two neighbouring sites share a byte, the one with the lower Y in the low 4 bits.
+*   2.-4. The counts of virions, innate immune cells and specialised immune cells on each site, one byte each, saturating at 255.
+**********************/
+class SpatialSnapshotWriter
+{
+private:
+    MPI_Comm snapshotComm;
+    int rank;
+
+    int gridSizeX;
+    int gridSizeY;
+    int localSizeX;
+    int localSizeY;
+    int cellsPerStateByte;
+
+    // The file types selecting this process's section of the state layer and of the count layers.
+    MPI_Datatype stateSectionType;
+    MPI_Datatype countSectionType;
+
+public:
+    // Needs to be called by all processes, each passing the position of its section in the grid.
+    SpatialSnapshotWriter(boost::mpi::communicator* comm, int gridSizeX, int gridSizeY, int localStartX, int localStartY, int localSizeX, int localSizeY);
+    ~SpatialSnapshotWriter();
+
+    // Writes a snapshot of this process's section. The vectors hold one value per local site, in row-major order. Needs to be called by all processes.
+    void write(std::string fileName, int tick, const std::vector<unsigned char>& epithelialCellStates, const std::vector<unsigned char>& virionCounts,
+               const std::vector<unsigned char>& innateImmuneCellCounts, const std::vector<unsigned char>& specialisedImmuneCellCounts);
+
+    // Parses a comma separated list of ticks, as given in the properties file.
+    static std::set<int> parseTicks(const std::string& ticksList);
+
+private:
+    void writeLayer(MPI_File file, MPI_Offset layerOffset, MPI_Datatype sectionType, const std::vector<unsigned char>& layer);
+};
+
+#endif // SPATIAL_SNAPSHOT
@@ -0,0 +1,73 @@
+/* Sweep_Design.h */
+#ifndef SWEEP_DESIGN
+#define SWEEP_DESIGN
+
+/**********************
+*   Include files
+**********************/
+#include <string>
+#include <vector>
+
+#include "Ensemble_Runner.h"
+
+
+/**********************
+* A swept parameter of the model and the range of its values. The values of an integer parameter are rounded to the nearest integer.
+**********************/
+struct SweepParameter
+{
+    std::string name;
+    double minValue;
+    double maxValue;
+    bool isInteger;
+};
+
+
+/**********************
+* Sweep Design class. Spreads the points of a parameter sweep over the ranges of the swept parameters with a space-filling design, so
+* a few dozen points cover the whole space instead of a grid which needs a point for each combination of values.
+*
+* The Latin hypercube design cuts the range of each parameter into as many equal strata as there are points, and places exactly one point
+* in each stratum of each parameter, at a random place within it, pairing the strata of the parameters at random.
+* The Sobol design takes the first points of the Sobol sequence (with the direction numbers of Joe and Kuo), which fill the space ever more
+* evenly as points are added. It is deterministic, and balanced on every parameter when the count of points is a power of 2.
+**********************/
+class SweepDesign
+{
+public:
+    enum DesignType{ LatinHypercube = 0, Sobol = 1 };
+
+    // The count of parameters the Sobol design can sweep.
+    static const int maxSobolParameters = 20;
+
+private:
+    std::vector<SweepParameter> parameters;
+
+    // The values of the parameters at each point, indexed [point * parameters count + parameter].
+    std::vector<double> pointValues;
+    int pointsCount;
+
+public:
+    // Creates a design of the passed count of points. The seed is only used by the Latin hypercube design.
+    SweepDesign(const std::vector<SweepParameter>& parameters, DesignType design, int pointsCount, unsigned int seed);
+
+    int getPointsCount() const {                                    return pointsCount;                                 }
+    int getParametersCount() const {                                return parameters.size();                           }
+    const SweepParameter& getParameter(int parameter) const {       return parameters[parameter];                       }
+    double getValue(int point, int parameter) const {               return pointValues[point * parameters.size() + parameter];  }
+
+    // Creates the jobs of the sweep: the replicates of each point in turn, each replicate with its own random seed, counted up from the base seed.
+    std::vector<EnsembleJob> createJobs(int replicatesCount, int baseSeed) const;
+
+    // Writes the design as CSV: the job, point, replicate and random seed of each job, and the values of the parameters at its point.
+    void writeDesign(std::string fileName, const std::vector<EnsembleJob>& jobs) const;
+
+    // Parses a comma separated list of swept parameters, each as name:min:max, or name:min:max:int for an integer parameter. Anything which is not a parameter is ignored.
+    static std::vector<SweepParameter> parseParameters(const std::string& parametersList);
+
+private:
+    void generateLatinHypercube(unsigned int seed);
+    void generateSobol();
+};
+
+#endif // SWEEP_DESIGN
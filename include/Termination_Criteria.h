@@ -0,0 +1,68 @@
+/* Termination_Criteria.h */
+#ifndef TERMINATION_CRITERIA
+#define TERMINATION_CRITERIA
+
+/**********************
+*   Include files
+**********************/
+#include <deque>
+#include <string>
+#include <vector>
+
+
+/**********************
+* Termination Criteria class. Stops the simulation before stop.at once the rest of the run could not change its outcome:
+* - the infection is extinct: no infected epithelial cells and no free virions in the last extinctionTicks records,
+* - the tissue is destroyed: no alive epithelial cells left,
+* - the populations are at a steady state: none of them has changed by more than the tolerance (relative to its size) over the last window of ticks.
+* The criteria are checked on the records of the agents data recorder, once their sums are complete. Those are the same on all processes,
+* so all processes decide to stop at the same tick and schedule the stop without any further communication.
+* The tick and the criterion which stopped the simulation are written to the termination file on rank 0.
+**********************/
+class TerminationCriteria
+{
+private:
+    int rank;
+    std::string outputFileName;
+
+    // The columns of the records the criteria are checked on. The population columns are the ones checked for a steady state.
+    int aliveCellsColumn;
+    int infectedCellsColumn;
+    int virionsColumn;
+    std::vector<int> populationColumns;
+
+    // The count of consecutive records with the infection extinct needed to stop (never if it is 0), and the count so far.
+    int extinctionTicks;
+    int extinctRecordsCount;
+
+    bool isTissueDestructionChecked;
+
+    // The count of ticks of the steady state window (never checked if it is 0), and the population values of the records in the window.
+    int steadyStateWindow;
+    double steadyStateTolerance;
+    std::deque<std::vector<long long> > windowValues;
+
+    // The reason of the termination, empty until the simulation has been stopped.
+    std::string terminationReason;
+    double terminationTick;
+
+public:
+    TerminationCriteria(int aliveCellsColumn, int infectedCellsColumn, int virionsColumn, const std::vector<int>& populationColumns,
+                        int extinctionTicks, bool isTissueDestructionChecked, int steadyStateWindow, double steadyStateTolerance, std::string outputFileName);
+
+    // Whether any criterion is enabled.
+    bool isEnabled() const;
+
+    // Checks the criteria on the summed values of the record of the tick, and schedules the stop if one of them is met. Needs to be called by all processes.
+    void check(double tick, const std::vector<long long>& values);
+
+    /* Getters */
+    bool hasTerminated() const {                                return !terminationReason.empty();      }
+    const std::string& getTerminationReason() const {           return terminationReason;               }
+    double getTerminationTick() const {                         return terminationTick;                 }
+
+private:
+    void terminate(double tick, std::string reason);
+};
+
+#endif // TERMINATION_CRITERIA
@@ -0,0 +1,71 @@
+/* Tissue_Cache.h */
+#ifndef TISSUE_CACHE
+#define TISSUE_CACHE
+
+/**********************
+*   Include files
+**********************/
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/**********************
+* The drawn parameters of an epithelial cell of the initial tissue. The other parameters of a new cell are fixed by the properties.
+**********************/
+struct TissueCellRecord
+{
+    double lifespan;
+    int age;
+    int timeSinceLastDivision;
+    double infectedLifespan;
+    double divisionRate;
+    double releaseDelay;
+    double displayVirProteinsDelay;
+    double virionReleaseRate;
+};
+
+
+/**********************
+* Tissue Cache class. Keeps the initial tissue of a process's section of the grid in a file, so a later run with the same key maps it back in
+* instead of drawing each cell again. The key is a hash of everything the tissue depends on (the epithelial parameters, the size of the grid,
+* the section of the process and the random seed), so a file of a different setup is never used.
+*
+* A file holds a header of 32 bytes ("VCTC", version, the key as a uint64, the count of cells and the length of the random engine state as uint64s),
+* the text form of the random number engine once the tissue was drawn, padded to a multiple of 8 bytes, and then the records of the cells in the
+* order they are created in. Restoring the engine along with the cells makes a cached run draw the exact same numbers after the tissue as an
+* uncached one. The values are in native byte order, as the files are only meant to be read back on the same machine.
+**********************/
+class TissueCache
+{
+private:
+    std::string fileName;
+    uint64_t key;
+
+    const unsigned char* fileData;
+    size_t fileSize;
+    const TissueCellRecord* cellRecords;
+    size_t cellsCount;
+    std::string randomEngineState;
+
+public:
+    // Caches the tissue of the process with the passed rank in the passed directory. Nothing is read until load is called.
+    TissueCache(std::string directory, uint64_t key, int rank);
+    ~TissueCache();
+
+    // Maps the cached tissue, returning false if there is none with the key and the expected count of cells.
+    bool load(size_t expectedCellsCount);
+
+    size_t getCellsCount() const {                                  return cellsCount;              }
+    const TissueCellRecord& getCell(size_t index) const {           return cellRecords[index];      }
+    const std::string& getRandomEngineState() const {               return randomEngineState;       }
+
+    // Writes the tissue to the cache, replacing the file only once it is complete.
+    bool store(const std::vector<TissueCellRecord>& records, const std::string& randomEngineState);
+
+private:
+    void close();
+};
+
+#endif // TISSUE_CACHE
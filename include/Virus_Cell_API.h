@@ -0,0 +1,81 @@
+/* Virus_Cell_API.h */
+#ifndef VIRUS_CELL_API
+#define VIRUS_CELL_API
+
+/**********************
+*   Include files
+**********************/
+#include <mpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**********************
+* The C API of the model library (libvirus_cell.a / libvirus_cell.so), for embedding the model into other programs, e.g. calibration frameworks,
+* which then run it in their own processes and read its results from memory, rather than launching the executable and parsing its output files.
+*
+* A model runs on the processes of the communicator passed to virus_cell_create, and all functions except the getters need to be called by
+* all of them. The process grid of the properties (count.of.processes.X.axis and Y.axis) needs to match the size of the communicator. MPI needs to be
+* initialised by the caller. As Repast HPC holds its state in singletons, a process can only have one model at a time.
+*
+* The metrics are the columns of the agents data records (e.g. the counts of the agents of each type), summed over the processes, with one record
+* per tick. The models still write their output files, into the output.directory set in the properties.
+**********************/
+typedef struct VirusCellModelHandle VirusCellModelHandle;
+
+
+/**********************
+* A property of the model overridden by the caller, e.g. { "virion.clearance.probability", 0.2 }. Integer properties need whole values.
+**********************/
+typedef struct VirusCellParameter
+{
+    const char* name;
+    double value;
+} VirusCellParameter;
+
+
+/**********************
+* The parameters of a model: the Repast configuration file, the properties file with the values of all properties, the properties overridden on top
+* of it, and the random seed (0 keeps the random.seed of the properties file).
+**********************/
+typedef struct VirusCellParameters
+{
+    const char* configFile;
+    const char* propsFile;
+    const VirusCellParameter* parameters;
+    int parametersCount;
+    int seed;
+} VirusCellParameters;
+
+
+// Creates the model on the processes of the communicator and its initial agents. Returns NULL on all processes if its files cannot be read on any of them.
+VirusCellModelHandle* virus_cell_create(MPI_Comm comm, const VirusCellParameters* parameters);
+
+// Runs the next ticksCount ticks of the model, recording the metrics of each. Returns the last tick run (0 before the first one).
+// Fewer ticks are run if the termination criteria of the properties stop the model early, and none after that.
+int virus_cell_run(VirusCellModelHandle* model, int ticksCount);
+
+// The termination criterion which stopped the model early (e.g. "infection extinct"), or an empty string if it has not been stopped.
+const char* virus_cell_get_termination_reason(const VirusCellModelHandle* model);
+
+// The metrics recorded so far: their count and names, the count of records (one per tick run), and the index of a metric by name (-1 if there is none).
+int virus_cell_get_metrics_count(const VirusCellModelHandle* model);
+const char* virus_cell_get_metric_name(const VirusCellModelHandle* model, int metric);
+int virus_cell_find_metric(const VirusCellModelHandle* model, const char* name);
+int virus_cell_get_records_count(const VirusCellModelHandle* model);
+
+// Copy the ticks of the records, or the values of a metric over the records, into the caller's array, up to its capacity. Return the count copied.
+int virus_cell_copy_ticks(const VirusCellModelHandle* model, double* ticks, int capacity);
+int virus_cell_copy_metric(const VirusCellModelHandle* model, int metric, long long* values, int capacity);
+
+// Destroys the model, after which another one can be created on the processes.
+void virus_cell_destroy(VirusCellModelHandle* model);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIRUS_CELL_API
@@ -5,13 +5,16 @@
 /**********************
 *   Include files
 **********************/
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_set>
 #include <boost/mpi.hpp>
 #include "repast_hpc/Schedule.h"
 #include "repast_hpc/Properties.h"
 #include "repast_hpc/SharedContext.h"
 #include "repast_hpc/AgentRequest.h"
 #include "repast_hpc/TDataSource.h"
-#include "repast_hpc/SVDataSet.h"
 
 // Spatial Projection includes
 #include "repast_hpc/SharedDiscreteSpace.h"
@@ -30,6 +33,16 @@
 // Include the file which contains all agent package syncrhonisation implementation
 #include "Agent_Synchronisation_Package_Pattern.h"
 
+// Include the communication layer connecting each process to its neighbouring processes
+#include "Process_Neighbourhood.h"
+#include "Selective_Buffer_Zone_Space.h"
+#include "Spatial_Snapshot.h"
+#include "Raster_Pyramid.h"
+#include "Plaque_Analysis.h"
+#include "Infection_Front.h"
+#include "Simulation_Checkpoint.h"
+#include "Tissue_Cache.h"
+
 
 
 /**********************
@@ -39,6 +52,55 @@ class VirusCellInteractionAgentsPackageProvider;
 class VirusCellInteractionAgentsPackageReceiver;
 
 
+/**********************
+*   Request of an epithelial cell agent to modify a neighbouring cell which is local to another process (divide into it or infect it).
+*   Sent to the process owning the neighbouring cell, which then carries the modification out on the original agent.
+**********************/
+struct NeighbouringCellModificationRequest
+{
+    int typeOfModification;
+    int cellToModifyId;
+    int cellToModifyStartRank;
+    int cellToModifyType;
+};
+
+
+/**********************
+*   Update of the copies of an epithelial cell agent held in the buffer zones of the neighbouring processes. Sent by the process owning the cell
+*   when the state of the cell has changed in a way the copies cannot work out by advancing themselves (see EpithelialCellAgent::advanceBufferZoneCopy).
+**********************/
+struct EpithelialCellHaloUpdate
+{
+    int cellId;
+    int cellStartRank;
+    double lifespan;
+    int age;
+    int internalState;
+    int externalState;
+    double infectedLifespan;
+    int timeInfected;
+    double divisionRate;
+    int timeSinceLastDivision;
+    double releaseDelay;
+    double displayVirProteinsDelay;
+    double extracellularReleaseProb;
+    double cellToCellTransmissionProb;
+    double virionReleaseRate;
+    double virionReleaseRemainder;
+};
+
+
+/**********************
+*   An epithelial cell agent on the boundary of this process's section of the grid, and its position in the section.
+**********************/
+struct BoundaryEpithelialCell
+{
+    EpithelialCellAgent* cell;
+    int x;
+    int y;
+};
+
+
 /**********************
 *   The model class
 **********************/
@@ -97,6 +159,7 @@ class VirusCellModel{
     
 
 	repast::Properties* props;
+    boost::mpi::communicator* modelComm;
     repast::SharedContext<VirusCellInteractionAgents> context;
 
     // Agent package provider and receiver
@@ -104,21 +167,107 @@ class VirusCellModel{
 	VirusCellInteractionAgentsPackageReceiver* agentReceiver;
 
     // Data collection variables
-    repast::SVDataSet* agentsData;
+    AgentsDataRecorder* agentsData;
 
     // The grid shared by the processes.
-    repast::SharedDiscreteSpace<VirusCellInteractionAgents, repast::WrapAroundBorders, repast::SimpleAdder<VirusCellInteractionAgents> >* discreteGridSpace;
+    SelectiveBufferZoneSpace<VirusCellInteractionAgents, repast::WrapAroundBorders, repast::SimpleAdder<VirusCellInteractionAgents> >* discreteGridSpace;
+
+    // The neighbourhood of this process in the process grid, and the modification requests to be sent to each of the neighbouring processes.
+    ProcessNeighbourhood* processNeighbourhood;
+    std::vector<std::vector<NeighbouringCellModificationRequest> > outgoingModificationRequests;
+    std::vector<NeighbouringCellModificationRequest> incomingModificationRequests;
+
+    // Only the cells on the boundary of this process's section of the grid can request modifications of cells on other processes.
+    // A cell requests at most one modification per step, so the requests to any neighbour can never be more than the boundary cells.
+    int maxModificationRequestsPerNeighbour;
+
+    // The count of steps between two synchronisations of the agent copies in the buffer zones. In between, the copies are advanced locally.
+    int haloExchangeInterval;
+
+    // Updates of the boundary epithelial cells to be sent to each neighbouring process on the steps between the halo synchronisations,
+    // and the states of the boundary cells when they were last sent, indexed by the cell's index in this process's section of the grid
+    // (-1 when the cell has been divided into since, so that it is sent again whatever its state).
+    std::vector<std::vector<EpithelialCellHaloUpdate> > outgoingHaloUpdates;
+    std::vector<EpithelialCellHaloUpdate> incomingHaloUpdates;
+    std::vector<int> lastSentBoundaryCellStates;
+
+    // The epithelial cells on the boundary of this process's section of the grid. The cells never move, so they are found once their agents
+    // have been created or restored, rather than by looking up the location of every agent on every step.
+    std::vector<BoundaryEpithelialCell> boundaryEpithelialCells;
+    std::unordered_set<VirusCellInteractionAgents*> boundaryEpithelialCellSet;
+
+    // Whether a mobile agent has left this process's section of the grid during the step. When no agent on any process has,
+    // the migration and projection synchronisations are skipped. This is only possible when no mobile agent types are copied into the buffer zones.
+    bool hasAgentLeftLocalSection;
+    bool hasSynchronisedProjection;
+    bool canSkipUnneededSynchronisation;
+
+    // The count of executed steps, and the time spent in them and in their synchronisation part since the last calibration run.
+    int executedStepsCount;
+    double accumulatedStepTime;
+    double accumulatedSynchronisationTime;
+
+    // Per-timestep timing of the pipelined step, recorded by rank 0 when enabled in the properties.
+    bool recordTimestepTiming;
+    std::ofstream timestepTimingOutput;
+
+    // The writer of the spatial snapshots of the grid, and the ticks at which they are taken (listed, and every snapshotInterval ticks if it is not 0).
+    SpatialSnapshotWriter* snapshotWriter;
+    std::set<int> snapshotTicks;
+    int snapshotInterval;
+
+    // The in-situ block summaries of the grid, written as a frame every rasterInterval ticks (never if it is 0).
+    RasterPyramid* rasterPyramid;
+    int rasterInterval;
+
+    // The in-situ analysis of the plaques of infected and dead epithelial cells, run on each tick before the record (nullptr if disabled).
+    PlaqueAnalysis* plaqueAnalysis;
+
+    // The in-situ tracking of the infection front around each focus, run on each tick before the record (nullptr if disabled).
+    InfectionFrontTracker* frontTracker;
+    int originCoordinate;
+
+    // The checkpoints of the full state of the simulation, written every checkpointInterval ticks (never if it is 0).
+    // A restarted simulation continues from the tick of its checkpoint, startTick, rather than from 0.
+    SimulationCheckpoint* checkpoint;
+    int checkpointInterval;
+    int startTick;
+
+    // The criteria for stopping the simulation before stop.at, checked on the records of the agents data (nullptr if none is enabled).
+    TerminationCriteria* terminationCriteria;
+
+    // The directory all outputs of the model are written into.
+    std::string outputDirectory;
 public:
-	VirusCellModel(std::string propsFile, int argc, char** argv, boost::mpi::communicator* comm);
+	VirusCellModel(std::string propsFile, int argc, char** argv, boost::mpi::communicator* comm, const std::map<std::string, std::string>* propertyOverrides = nullptr);
 	~VirusCellModel();
 	void init();
 	void initSchedule(repast::ScheduleRunner& runner);
+    void reset(const std::map<std::string, std::string>& parameters, int seed);
+    void runCalibrationSteps(int stepsCount, double& stepTime, double& synchronisationTime);
+
+    AgentsDataRecorder* getAgentsData() const {                 return agentsData;              }
+    TerminationCriteria* getTerminationCriteria() const {       return terminationCriteria;     }
 
 private:
     void printEndOfTimestep();
 	void executeTimestep();
     void recordResults();
+    void writeSpatialSnapshot();
+    void writeRasterFrame();
+    void analysePlaques();
+    void trackInfectionFront();
+    void writeCheckpoint();
+    bool restoreFromCheckpoint(std::string fileName, bool isFork);
+    void applyForkedParameters(const std::string& checkpointParametersText, std::vector<CheckpointAgentRecord>& agentRecords);
+    std::string getParametersText() const;
+    void readParameters();
+    void createTerminationCriteria();
 
+    void initialiseTissue();
+    void createTissueFromRecords(const TissueCellRecord* cellRecords);
+    void drawTissueInBulk(std::vector<TissueCellRecord>& cellRecords);
+    void drawTissueColumns(int firstColumn, int columnsStep, std::vector<TissueCellRecord>& cellRecords) const;
     void initialiseEpithelialCellAgent( int epithelialCellIndex, int xCoor, int yCoor, bool isExistingAgentObject, EpithelialCellAgent* theExistingCellObject );
     void initialiseVirionAgent(int virionIndex, bool isAReleasedVirus, int xCoor, int yCoor);
     void initialiseInnateImmuneCellAgent( int immuneCellId, bool isFreshCell );
@@ -126,10 +275,21 @@ private:
 
     void checkForCellDivision(VirusCellInteractionAgents* theEpithelialCellAgent);
     void checkForCellToCellInfection(VirusCellInteractionAgents* theEpithelialCellAgent);
+    void divideIntoLocalCell(repast::AgentId cellToDivideIntoId);
+    void infectLocalCell(repast::AgentId cellToInfectId);
+    void requestNeighbouringCellModification(EpithelialCellAgent::NeighbouringCellModificationType typeOfModification, repast::AgentId cellToModifyId);
+    void applyNeighbouringCellModificationRequests();
+
+    void stepLocalAgent(VirusCellInteractionAgents* theAgent);
+    void findBoundaryEpithelialCells();
+    void advanceBufferZoneEpithelialCells();
+    bool collectBoundaryEpithelialCellUpdates(bool areCopiesSynchronisedByRepast);
+    void exchangeBoundaryEpithelialCellUpdates();
+    void applyEpithelialCellHaloUpdates();
     void checkForCellVirionRelease(VirusCellInteractionAgents* theEpithelialCellAgent);
     void checkForSpecialisedImmuneCellRecruitement(VirusCellInteractionAgents* theRecruitingImmuneCell);
     void checkForInnateImmuneCellRecruitment(VirusCellInteractionAgents* theRecruitingImmuneCell);
-    void removeLocalAgentIfDead(VirusCellInteractionAgents* theAgent);
+    bool removeLocalAgentIfDead(VirusCellInteractionAgents* theAgent);
 };
 
 #endif // #ifndef VIRUS_CELL_MODEL
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "Virion_Agent.h"
 #include "Innate_Immune_Cell.h"
 #include "Specialised_Immune_Cell.h"
+#include "Population_Counters.h"
 
 
 /*****************************
@@ -241,7 +242,8 @@ void VirusCellInteractionAgentsPackageProvider::provideContent(repast::AgentRequ
 *   VirusCellInteractionAgentsPackageReceiver::VirusCellInteractionAgentsPackageReceiver - Constructor for the package receiver
 **********************/
 VirusCellInteractionAgentsPackageReceiver::VirusCellInteractionAgentsPackageReceiver(repast::SharedContext<VirusCellInteractionAgents>* contextPtr): 
-agentsContext(contextPtr)
+agentsContext(contextPtr),
+isReceivingMigratingAgents(false)
 {
 
 }
@@ -254,6 +256,12 @@ agentsContext(contextPtr)
 VirusCellInteractionAgents * VirusCellInteractionAgentsPackageReceiver::createAgent(VirusCellInteractionAgentPackage package){
     repast::AgentId theAgentId(package.id, package.rank, package.type, package.currentRank);
 
+    // The epithelial cells never move, so only the mobile agents can arrive on this process.
+    if( isReceivingMigratingAgents && package.type != 0 )
+    {
+        PopulationCounters::instance()->mobileAgentAdded(package.type);
+    }
+
     // Create the correct agent type, using the appropriate package variable values.
     if(package.type == 0)
     {
@@ -0,0 +1,359 @@
+/* Columnar_Time_Series.cpp */
+// Implements the writer and the memory-mapped reader of the binary columnar time-series format.
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Columnar_Time_Series.h"
+
+
+static const char columnarMagic[4] = { 'V', 'C', 'T', 'S' };
+static const uint32_t columnarVersion = 1;
+
+
+/**********************
+*   appendLittleEndian - Appends the lowest byteCount bytes of the value to the buffer, least significant first.
+**********************/
+static void appendLittleEndian(std::string& buffer, uint64_t value, int byteCount)
+{
+    for( int b = 0; b < byteCount; ++b )
+    {
+        buffer.push_back(static_cast<char>((value >> (8 * b)) & 0xFF));
+    }
+}
+
+
+
+/**********************
+*   readLittleEndian - Reads a byteCount bytes long little-endian value, if it fits before the end. Advances the offset past it.
+**********************/
+static bool readLittleEndian(const unsigned char* data, size_t size, size_t& offset, int byteCount, uint64_t& value)
+{
+    if( offset + byteCount > size )
+    {
+        return false;
+    }
+
+    value = 0;
+    for( int b = 0; b < byteCount; ++b )
+    {
+        value |= static_cast<uint64_t>(data[offset + b]) << (8 * b);
+    }
+    offset += byteCount;
+    return true;
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesWriter::ColumnarTimeSeriesWriter - Constructor. Creates the file and writes its header.
+**********************/
+ColumnarTimeSeriesWriter::ColumnarTimeSeriesWriter(std::string fileName, uint64_t parametersHash, uint64_t seed, const std::vector<std::string>& valueColumnNames):
+output(fileName.c_str(), std::ios::binary | std::ios::trunc),
+valueColumnsCount(valueColumnNames.size())
+{
+    std::string header(columnarMagic, 4);
+    appendLittleEndian(header, columnarVersion, 4);
+    appendLittleEndian(header, parametersHash, 8);
+    appendLittleEndian(header, seed, 8);
+    appendLittleEndian(header, valueColumnsCount + 1, 4);
+
+    std::vector<std::string> columnNames(1, "tick");
+    columnNames.insert(columnNames.end(), valueColumnNames.begin(), valueColumnNames.end());
+    for( size_t c = 0; c < columnNames.size(); ++c )
+    {
+        header.push_back(static_cast<char>(c == 0 ? Float64Column : Int64Column));
+        appendLittleEndian(header, columnNames[c].size(), 4);
+        header += columnNames[c];
+    }
+
+    output.write(header.data(), header.size());
+    output.flush();
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesWriter::appendChunk - Encodes the passed rows column by column and appends them to the file as one chunk.
+**********************/
+void ColumnarTimeSeriesWriter::appendChunk(const std::vector<double>& ticks, const std::vector<long long>& values)
+{
+    if( ticks.empty() )
+    {
+        return;
+    }
+
+    std::string chunk;
+    appendLittleEndian(chunk, ticks.size(), 4);
+
+    std::string encodedColumn;
+    for( size_t r = 0; r < ticks.size(); ++r )
+    {
+        uint64_t tickBits;
+        std::memcpy(&tickBits, &ticks[r], sizeof(tickBits));
+        appendLittleEndian(encodedColumn, tickBits, 8);
+    }
+    appendLittleEndian(chunk, encodedColumn.size(), 4);
+    chunk += encodedColumn;
+
+    for( size_t c = 0; c < valueColumnsCount; ++c )
+    {
+        encodedColumn.clear();
+        long long previousValue = 0;
+        for( size_t r = 0; r < ticks.size(); ++r )
+        {
+            long long value = values[r * valueColumnsCount + c];
+            int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(previousValue));
+            previousValue = value;
+
+            // Zigzag maps the small negative differences onto small unsigned numbers, then the varint writes 7 bits per byte.
+            uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+            while( zigzag >= 0x80 )
+            {
+                encodedColumn.push_back(static_cast<char>((zigzag & 0x7F) | 0x80));
+                zigzag >>= 7;
+            }
+            encodedColumn.push_back(static_cast<char>(zigzag));
+        }
+        appendLittleEndian(chunk, encodedColumn.size(), 4);
+        chunk += encodedColumn;
+    }
+
+    output.write(chunk.data(), chunk.size());
+    output.flush();
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesWriter::hashText - Hashes the passed text with the 64-bit FNV-1a hash.
+**********************/
+uint64_t ColumnarTimeSeriesWriter::hashText(const std::string& text)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for( size_t i = 0; i < text.size(); ++i )
+    {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesReader::ColumnarTimeSeriesReader - Constructor. No file is mapped until open is called.
+**********************/
+ColumnarTimeSeriesReader::ColumnarTimeSeriesReader():
+fileData(nullptr),
+fileSize(0),
+parametersHash(0),
+seed(0)
+{
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesReader::~ColumnarTimeSeriesReader - Destructor. Unmaps the file.
+**********************/
+ColumnarTimeSeriesReader::~ColumnarTimeSeriesReader()
+{
+    close();
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesReader::close - Unmaps the file, if one is mapped, and forgets its layout.
+**********************/
+void ColumnarTimeSeriesReader::close()
+{
+    if( fileData != nullptr )
+    {
+        munmap(const_cast<unsigned char*>(fileData), fileSize);
+        fileData = nullptr;
+    }
+    fileSize = 0;
+
+    columnNames.clear();
+    columnTypes.clear();
+    chunkRowsCounts.clear();
+    chunkColumnOffsets.clear();
+    chunkColumnBytes.clear();
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesReader::open - Maps the file into memory, reads the header and finds the columns of each complete chunk.
+*   Only the layout is read here, the values are decoded when a column is requested.
+**********************/
+bool ColumnarTimeSeriesReader::open(std::string fileName)
+{
+    close();
+
+    int fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+    if( fileDescriptor < 0 )
+    {
+        return false;
+    }
+
+    struct stat fileStatus;
+    if( fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < 28 )
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    fileSize = fileStatus.st_size;
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    ::close(fileDescriptor);
+    if( mapping == MAP_FAILED )
+    {
+        fileSize = 0;
+        return false;
+    }
+    fileData = static_cast<const unsigned char*>(mapping);
+
+    uint64_t version, columnsCount;
+    size_t offset = 4;
+    if( std::memcmp(fileData, columnarMagic, 4) != 0 || !readLittleEndian(fileData, fileSize, offset, 4, version) || version != columnarVersion
+        || !readLittleEndian(fileData, fileSize, offset, 8, parametersHash) || !readLittleEndian(fileData, fileSize, offset, 8, seed)
+        || !readLittleEndian(fileData, fileSize, offset, 4, columnsCount) )
+    {
+        close();
+        return false;
+    }
+
+    for( uint64_t c = 0; c < columnsCount; ++c )
+    {
+        uint64_t nameLength;
+        if( offset >= fileSize )
+        {
+            close();
+            return false;
+        }
+        int columnType = fileData[offset++];
+        if( !readLittleEndian(fileData, fileSize, offset, 4, nameLength) || offset + nameLength > fileSize )
+        {
+            close();
+            return false;
+        }
+        columnTypes.push_back(columnType);
+        columnNames.push_back(std::string(reinterpret_cast<const char*>(fileData + offset), nameLength));
+        offset += nameLength;
+    }
+
+    // Find the chunks. A chunk which does not fit in the rest of the file was cut short while being written, so it and anything after it are ignored.
+    while( offset < fileSize )
+    {
+        uint64_t rowsCount;
+        size_t chunkOffset = offset;
+        bool isChunkComplete = readLittleEndian(fileData, fileSize, chunkOffset, 4, rowsCount);
+
+        std::vector<size_t> columnOffsets;
+        std::vector<uint32_t> columnBytes;
+        for( uint64_t c = 0; c < columnsCount && isChunkComplete; ++c )
+        {
+            uint64_t byteCount;
+            isChunkComplete = readLittleEndian(fileData, fileSize, chunkOffset, 4, byteCount) && chunkOffset + byteCount <= fileSize;
+            if( isChunkComplete )
+            {
+                columnOffsets.push_back(chunkOffset);
+                columnBytes.push_back(byteCount);
+                chunkOffset += byteCount;
+            }
+        }
+
+        if( !isChunkComplete )
+        {
+            break;
+        }
+
+        chunkRowsCounts.push_back(rowsCount);
+        chunkColumnOffsets.push_back(columnOffsets);
+        chunkColumnBytes.push_back(columnBytes);
+        offset = chunkOffset;
+    }
+
+    return true;
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesReader::getRowsCount - Gets the count of rows in all complete chunks.
+**********************/
+size_t ColumnarTimeSeriesReader::getRowsCount() const
+{
+    size_t rowsCount = 0;
+    for( size_t k = 0; k < chunkRowsCounts.size(); ++k )
+    {
+        rowsCount += chunkRowsCounts[k];
+    }
+
+    return rowsCount;
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesReader::readFloat64Column - Appends the values of a float64 column of all chunks to the passed vector.
+**********************/
+void ColumnarTimeSeriesReader::readFloat64Column(size_t column, std::vector<double>& values) const
+{
+    for( size_t k = 0; k < chunkRowsCounts.size(); ++k )
+    {
+        size_t offset = chunkColumnOffsets[k][column];
+        size_t columnEnd = offset + chunkColumnBytes[k][column];
+        for( uint32_t r = 0; r < chunkRowsCounts[k]; ++r )
+        {
+            uint64_t valueBits = 0;
+            readLittleEndian(fileData, columnEnd, offset, 8, valueBits);
+
+            double value;
+            std::memcpy(&value, &valueBits, sizeof(value));
+            values.push_back(value);
+        }
+    }
+}
+
+
+
+/**********************
+*   ColumnarTimeSeriesReader::readInt64Column - Appends the values of an int64 column of all chunks to the passed vector,
+*   undoing the varint, zigzag and delta encoding.
+**********************/
+void ColumnarTimeSeriesReader::readInt64Column(size_t column, std::vector<long long>& values) const
+{
+    for( size_t k = 0; k < chunkRowsCounts.size(); ++k )
+    {
+        size_t offset = chunkColumnOffsets[k][column];
+        size_t columnEnd = offset + chunkColumnBytes[k][column];
+        uint64_t previousValue = 0;
+        for( uint32_t r = 0; r < chunkRowsCounts[k]; ++r )
+        {
+            uint64_t zigzag = 0;
+            int shift = 0;
+            while( offset < columnEnd && shift < 64 )
+            {
+                unsigned char encodedByte = fileData[offset++];
+                zigzag |= static_cast<uint64_t>(encodedByte & 0x7F) << shift;
+                shift += 7;
+                if( (encodedByte & 0x80) == 0 )
+                {
+                    break;
+                }
+            }
+
+            uint64_t delta = (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+            previousValue += delta;
+            values.push_back(static_cast<long long>(previousValue));
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/* Columnar_To_CSV.cpp */
+// Converts a binary columnar time-series file back into the CSV layout of agents_data.csv.
+// Usage: Columnar_To_CSV.exe <input.vcts> [output.csv]. Without an output file the CSV is written to the standard output.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Columnar_Time_Series.h"
+
+
+int main(int argc, char** argv){
+
+	if( argc < 2 )
+	{
+		std::cout<<"Usage: "<<argv[0]<<" <input.vcts> [output.csv]"<<std::endl;
+		return 1;
+	}
+
+	ColumnarTimeSeriesReader reader;
+	if( !reader.open(argv[1]) )
+	{
+		std::cout<<"Could not read "<<argv[1]<<" as a columnar time-series file!"<<std::endl;
+		return 1;
+	}
+
+	std::ofstream outputFile;
+	if( argc > 2 )
+	{
+		outputFile.open(argv[2]);
+	}
+	std::ostream& output = (argc > 2) ? outputFile : std::cout;
+
+	// Decode all columns up front, then write them out row by row.
+	size_t columnsCount = reader.getColumnsCount();
+	std::vector<std::vector<double> > float64Columns(columnsCount);
+	std::vector<std::vector<long long> > int64Columns(columnsCount);
+	for( size_t c = 0; c < columnsCount; ++c )
+	{
+		if( reader.getColumnType(c) == Float64Column )
+		{
+			reader.readFloat64Column(c, float64Columns[c]);
+		}
+		else
+		{
+			reader.readInt64Column(c, int64Columns[c]);
+		}
+	}
+
+	for( size_t c = 0; c < columnsCount; ++c )
+	{
+		output<<(c > 0 ? "," : "")<<reader.getColumnName(c);
+	}
+	output<<"\n";
+
+	size_t rowsCount = reader.getRowsCount();
+	for( size_t r = 0; r < rowsCount; ++r )
+	{
+		for( size_t c = 0; c < columnsCount; ++c )
+		{
+			output<<(c > 0 ? "," : "");
+			if( reader.getColumnType(c) == Float64Column )
+			{
+				output<<float64Columns[c][r];
+			}
+			else
+			{
+				output<<int64Columns[c][r];
+			}
+		}
+		output<<"\n";
+	}
+	output.flush();
+
+	return 0;
+}
@@ -4,8 +4,47 @@
 /***********************************
 ********** DATA COLLECTION *********
 ***********************************/
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+#include "repast_hpc/RepastProcess.h"
+
 #include "Data_Collection.h"
 
+
+/**********************
+*   reportCountMismatch - Reports a count kept by the population counters which differs from the count found by scanning the local agents.
+**********************/
+static void reportCountMismatch(const char* countName, int counterValue, int scannedValue)
+{
+    if( counterValue != scannedValue )
+    {
+        std::cout<<"Population counter mismatch on rank "<<repast::RepastProcess::instance()->rank()<<" at tick "
+            <<repast::RepastProcess::instance()->getScheduleRunner().currentTick()<<": "<<countName<<" counted "<<counterValue
+            <<", scanned "<<scannedValue<<std::endl;
+    }
+}
+
+
+
+/**********************
+*   syncFileToDisk - Makes sure the flushed contents of the named file have reached the disk. fsync works on any descriptor of the file,
+*   so the file is opened again for reading, as the output streams do not expose theirs.
+**********************/
+static void syncFileToDisk(const std::string& fileName)
+{
+    int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if( fileDescriptor >= 0 )
+    {
+        fsync(fileDescriptor);
+        close(fileDescriptor);
+    }
+}
+
+
+
 /******************************************
 * Data Source class for tracking the count of alive epithelial cells in the model
 ******************************************/
@@ -14,8 +53,9 @@
 /**********************
 *   DataSource_EpithelialCellsCount::DataSource_EpithelialCellsCount - Constructor
 **********************/
-DataSource_EpithelialCellsCount::DataSource_EpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext):
-context(theContext)
+DataSource_EpithelialCellsCount::DataSource_EpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked):
+context(theContext),
+isCrossChecked(theIsCrossChecked)
 {
 
 }
@@ -23,9 +63,25 @@ context(theContext)
 
 
 /**********************
-*   DataSource_EpithelialCellsCount::getData - Gets the agents of type Epithelial cell on this process and counts how many are alive
+*   DataSource_EpithelialCellsCount::getData - Gets the count of alive epithelial cells on this process from the population counters.
 **********************/
 int DataSource_EpithelialCellsCount::getData()
+{
+    int count = PopulationCounters::instance()->getAliveEpithelialCellsCount();
+    if( isCrossChecked )
+    {
+        reportCountMismatch("alive epithelial cells", count, countByScan());
+    }
+
+    return count;
+}
+
+
+
+/**********************
+*   DataSource_EpithelialCellsCount::countByScan - Gets the agents of type Epithelial cell on this process and counts how many are alive
+**********************/
+int DataSource_EpithelialCellsCount::countByScan()
 {
     int aliveEpithCellsCount = 0;
 
@@ -60,17 +116,34 @@ int DataSource_EpithelialCellsCount::getData()
 /**********************
 *   DataSource_VirionsCount::DataSource_VirionsCount - Constructor
 **********************/
-DataSource_VirionsCount::DataSource_VirionsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext):
-context(theContext)
+DataSource_VirionsCount::DataSource_VirionsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked):
+context(theContext),
+isCrossChecked(theIsCrossChecked)
 {
 
 }
 
 
 /**********************
-*   DataSource_VirionsCount::getData - Gets the count of Virion Agents on this process
+*   DataSource_VirionsCount::getData - Gets the count of virions on this process from the population counters.
 **********************/
 int DataSource_VirionsCount::getData()
+{
+    int count = PopulationCounters::instance()->getVirionsCount();
+    if( isCrossChecked )
+    {
+        reportCountMismatch("virions", count, countByScan());
+    }
+
+    return count;
+}
+
+
+
+/**********************
+*   DataSource_VirionsCount::countByScan - Gets the count of Virion Agents on this process
+**********************/
+int DataSource_VirionsCount::countByScan()
 {
     std::vector<VirusCellInteractionAgents*> theVirions;
     
@@ -89,17 +162,34 @@ int DataSource_VirionsCount::getData()
 /**********************
 *   DataSource_InnateImmuneCellsCount::DataSource_InnateImmuneCellsCount - Constructor
 **********************/
-DataSource_InnateImmuneCellsCount::DataSource_InnateImmuneCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext):
-context(theContext)
+DataSource_InnateImmuneCellsCount::DataSource_InnateImmuneCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked):
+context(theContext),
+isCrossChecked(theIsCrossChecked)
 {
 
 }
 
 
 /**********************
-*   DataSource_InnateImmuneCellsCount::getData - Gets the count of Innate Immune Cell Agents on this process
+*   DataSource_InnateImmuneCellsCount::getData - Gets the count of innate immune cells on this process from the population counters.
 **********************/
 int DataSource_InnateImmuneCellsCount::getData()
+{
+    int count = PopulationCounters::instance()->getInnateImmuneCellsCount();
+    if( isCrossChecked )
+    {
+        reportCountMismatch("innate immune cells", count, countByScan());
+    }
+
+    return count;
+}
+
+
+
+/**********************
+*   DataSource_InnateImmuneCellsCount::countByScan - Gets the count of Innate Immune Cell Agents on this process
+**********************/
+int DataSource_InnateImmuneCellsCount::countByScan()
 {
     std::vector<VirusCellInteractionAgents*> theInnateImmuneCells;
     
@@ -118,17 +208,34 @@ int DataSource_InnateImmuneCellsCount::getData()
 /**********************
 *   DataSource_SpecialisedImmuneCellsCount::DataSource_SpecialisedImmuneCellsCount - Constructor
 **********************/
-DataSource_SpecialisedImmuneCellsCount::DataSource_SpecialisedImmuneCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext):
-context(theContext)
+DataSource_SpecialisedImmuneCellsCount::DataSource_SpecialisedImmuneCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked):
+context(theContext),
+isCrossChecked(theIsCrossChecked)
 {
 
 }
 
 
 /**********************
-*   DataSource_SpecialisedImmuneCellsCount::getData - Gets the count of Specialised Immune Cell Agents on this process
+*   DataSource_SpecialisedImmuneCellsCount::getData - Gets the count of specialised immune cells on this process from the population counters.
 **********************/
 int DataSource_SpecialisedImmuneCellsCount::getData()
+{
+    int count = PopulationCounters::instance()->getSpecialisedImmuneCellsCount();
+    if( isCrossChecked )
+    {
+        reportCountMismatch("specialised immune cells", count, countByScan());
+    }
+
+    return count;
+}
+
+
+
+/**********************
+*   DataSource_SpecialisedImmuneCellsCount::countByScan - Gets the count of Specialised Immune Cell Agents on this process
+**********************/
+int DataSource_SpecialisedImmuneCellsCount::countByScan()
 {
     std::vector<VirusCellInteractionAgents*> theSpecialisedImmuneCells;
     
@@ -147,17 +254,34 @@ int DataSource_SpecialisedImmuneCellsCount::getData()
 /**********************
 *   DataSource_InfectedEpithelialCellsCount::DataSource_InfectedEpithelialCellsCount - Constructor
 **********************/
-DataSource_InfectedEpithelialCellsCount::DataSource_InfectedEpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext):
-context(theContext)
+DataSource_InfectedEpithelialCellsCount::DataSource_InfectedEpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked):
+context(theContext),
+isCrossChecked(theIsCrossChecked)
 {
 
 }
 
 
 /**********************
-*   DataSource_InfectedEpithelialCellsCount::getData - Gets the count of Infected Epithelial Cell Agents on this process
+*   DataSource_InfectedEpithelialCellsCount::getData - Gets the count of infected epithelial cells on this process from the population counters.
 **********************/
 int DataSource_InfectedEpithelialCellsCount::getData()
+{
+    int count = PopulationCounters::instance()->getInfectedEpithelialCellsCount();
+    if( isCrossChecked )
+    {
+        reportCountMismatch("infected epithelial cells", count, countByScan());
+    }
+
+    return count;
+}
+
+
+
+/**********************
+*   DataSource_InfectedEpithelialCellsCount::countByScan - Gets the count of Infected Epithelial Cell Agents on this process
+**********************/
+int DataSource_InfectedEpithelialCellsCount::countByScan()
 {
     int infectedEpithCells = 0;
 
@@ -191,17 +315,34 @@ int DataSource_InfectedEpithelialCellsCount::getData()
 /**********************
 *   DataSource_DeadEpithelialCellsCount::DataSource_DeadEpithelialCellsCount - Constructor
 **********************/
-DataSource_DeadEpithelialCellsCount::DataSource_DeadEpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext):
-context(theContext)
+DataSource_DeadEpithelialCellsCount::DataSource_DeadEpithelialCellsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked):
+context(theContext),
+isCrossChecked(theIsCrossChecked)
 {
 
 }
 
 
 /**********************
-*   DataSource_DeadEpithelialCellsCount::getData - Gets the count of Dead Epithelial Cell Agents on this process
+*   DataSource_DeadEpithelialCellsCount::getData - Gets the count of dead epithelial cells on this process from the population counters.
 **********************/
 int DataSource_DeadEpithelialCellsCount::getData()
+{
+    int count = PopulationCounters::instance()->getDeadEpithelialCellsCount();
+    if( isCrossChecked )
+    {
+        reportCountMismatch("dead epithelial cells", count, countByScan());
+    }
+
+    return count;
+}
+
+
+
+/**********************
+*   DataSource_DeadEpithelialCellsCount::countByScan - Gets the count of Dead Epithelial Cell Agents on this process
+**********************/
+int DataSource_DeadEpithelialCellsCount::countByScan()
 {
     int deadEpithCells = 0;
 
@@ -235,17 +376,34 @@ int DataSource_DeadEpithelialCellsCount::getData()
 /**********************
 *   DataSource_TotalAgentsCount::DataSource_TotalAgentsCount - Constructor
 **********************/
-DataSource_TotalAgentsCount::DataSource_TotalAgentsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext):
-context(theContext)
+DataSource_TotalAgentsCount::DataSource_TotalAgentsCount(repast::SharedContext<VirusCellInteractionAgents>* theContext, bool theIsCrossChecked):
+context(theContext),
+isCrossChecked(theIsCrossChecked)
 {
 
 }
 
 
 /**********************
-*   DataSource_TotalAgentsCount::getData - Gets the total count of agents on this process
+*   DataSource_TotalAgentsCount::getData - Gets the count of agents in total on this process from the population counters.
 **********************/
 int DataSource_TotalAgentsCount::getData()
+{
+    int count = PopulationCounters::instance()->getTotalAgentsCount();
+    if( isCrossChecked )
+    {
+        reportCountMismatch("agents in total", count, countByScan());
+    }
+
+    return count;
+}
+
+
+
+/**********************
+*   DataSource_TotalAgentsCount::countByScan - Gets the total count of agents on this process
+**********************/
+int DataSource_TotalAgentsCount::countByScan()
 {
     std::vector<VirusCellInteractionAgents*> theAgents;
     
@@ -253,4 +411,419 @@ int DataSource_TotalAgentsCount::getData()
     context->selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theAgents, false);
     
     return theAgents.size();
-}
\ No newline at end of file
+}
+
+
+
+/******************************************
+* Data Source classes for tracking the plaques in the model
+******************************************/
+
+/**********************
+*   DataSource_PlaqueCount::DataSource_PlaqueCount - Constructor
+**********************/
+DataSource_PlaqueCount::DataSource_PlaqueCount(PlaqueAnalysis* thePlaqueAnalysis):
+plaqueAnalysis(thePlaqueAnalysis)
+{
+
+}
+
+
+/**********************
+*   DataSource_PlaqueCount::getData - Gets the count of plaques on the whole grid on rank 0, and 0 on the other processes.
+**********************/
+int DataSource_PlaqueCount::getData()
+{
+    return repast::RepastProcess::instance()->rank() == 0 ? plaqueAnalysis->getPlaqueCount() : 0;
+}
+
+
+
+/**********************
+*   DataSource_LargestPlaqueArea::DataSource_LargestPlaqueArea - Constructor
+**********************/
+DataSource_LargestPlaqueArea::DataSource_LargestPlaqueArea(PlaqueAnalysis* thePlaqueAnalysis):
+plaqueAnalysis(thePlaqueAnalysis)
+{
+
+}
+
+
+/**********************
+*   DataSource_LargestPlaqueArea::getData - Gets the count of sites of the largest plaque on rank 0, and 0 on the other processes.
+**********************/
+int DataSource_LargestPlaqueArea::getData()
+{
+    return repast::RepastProcess::instance()->rank() == 0 ? plaqueAnalysis->getLargestPlaqueArea() : 0;
+}
+
+
+
+/**********************
+*   DataSource_PlaqueSizeCount::DataSource_PlaqueSizeCount - Constructor
+**********************/
+DataSource_PlaqueSizeCount::DataSource_PlaqueSizeCount(PlaqueAnalysis* thePlaqueAnalysis, int theSizeBin):
+plaqueAnalysis(thePlaqueAnalysis),
+sizeBin(theSizeBin)
+{
+
+}
+
+
+/**********************
+*   DataSource_PlaqueSizeCount::getData - Gets the count of plaques in the size bin on rank 0, and 0 on the other processes.
+**********************/
+int DataSource_PlaqueSizeCount::getData()
+{
+    return repast::RepastProcess::instance()->rank() == 0 ? plaqueAnalysis->getPlaqueCountInSizeBin(sizeBin) : 0;
+}
+
+
+
+/******************************************
+* Data Source class for tracking the infection front around a focus
+******************************************/
+
+/**********************
+*   DataSource_InfectionFront::DataSource_InfectionFront - Constructor
+**********************/
+DataSource_InfectionFront::DataSource_InfectionFront(InfectionFrontTracker* theFrontTracker, int theFocus, Quantity theQuantity, int theOriginCoordinate):
+frontTracker(theFrontTracker),
+focus(theFocus),
+quantity(theQuantity),
+originCoordinate(theOriginCoordinate)
+{
+
+}
+
+
+/**********************
+*   DataSource_InfectionFront::getData - Gets the quantity of the focus in hundredths of a site on rank 0, and 0 on the other processes
+*   or before the focus has been anchored.
+**********************/
+int DataSource_InfectionFront::getData()
+{
+    if( repast::RepastProcess::instance()->rank() != 0 || !frontTracker->isAnchored() )
+    {
+        return 0;
+    }
+
+    double value = 0.0;
+    switch( quantity )
+    {
+        case CentroidX:             value = frontTracker->getCentroidX(focus) + originCoordinate;       break;
+        case CentroidY:             value = frontTracker->getCentroidY(focus) + originCoordinate;       break;
+        case RadiusOfGyration:      value = frontTracker->getRadiusOfGyration(focus);                   break;
+        case MaxInfectedRadius:     value = frontTracker->getMaxInfectedRadius(focus);                  break;
+        case FrontVelocity:         value = frontTracker->getFrontVelocity(focus);                      break;
+    }
+
+    return static_cast<int>(std::lround(value * 100.0));
+}
+
+
+
+/******************************************
+* Agents Data Recorder class
+******************************************/
+
+/**********************
+*   AgentsDataRecorder::AgentsDataRecorder - Constructor. The reductions run on a duplicate of the passed communicator, so they cannot be
+*   matched with the collectives of the model which are called while a reduction is in flight. Rank 0 starts its writer thread. 
+*   The file is only opened at the first write.
+**********************/
+AgentsDataRecorder::AgentsDataRecorder(std::string fileName, boost::mpi::communicator* comm):
+reductionRequest(MPI_REQUEST_NULL),
+isReductionInFlight(false),
+tickInFlight(0.0),
+writerQueue(64),
+outputFileName(fileName),
+isRetainingRecords(false),
+terminationCriteria(nullptr),
+isColumnarOutputEnabled(false),
+columnarParametersHash(0),
+columnarSeed(0),
+columnarOutput(nullptr)
+{
+    MPI_Comm_dup(*comm, &recorderComm);
+    MPI_Comm_rank(recorderComm, &rank);
+
+    if( rank == 0 )
+    {
+        writerThread = std::thread(&AgentsDataRecorder::runWriterThread, this);
+    }
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::~AgentsDataRecorder - Destructor. Completes the reduction in flight, stops the writer thread and deletes the data sources.
+*   Records which were not written by a scheduled write are dropped, as they are by the Repast data sets.
+**********************/
+AgentsDataRecorder::~AgentsDataRecorder()
+{
+    if( isReductionInFlight )
+    {
+        MPI_Wait(&reductionRequest, MPI_STATUS_IGNORE);
+    }
+    MPI_Comm_free(&recorderComm);
+
+    if( writerThread.joinable() )
+    {
+        AgentsDataQueueItem stopItem;
+        stopItem.kind = AgentsDataQueueItem::Stop;
+        writerQueue.push(stopItem);
+        writerThread.join();
+    }
+
+    for( size_t i = 0; i < dataSources.size(); ++i )
+    {
+        delete dataSources[i];
+    }
+    delete columnarOutput;
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::addDataSource - Adds a data source, whose values are recorded in a column with the passed name.
+**********************/
+void AgentsDataRecorder::addDataSource(std::string columnName, repast::TDataSource<int>* dataSource)
+{
+    columnNames.push_back(columnName);
+    dataSources.push_back(dataSource);
+    localValues.push_back(0);
+    summedValues.push_back(0);
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::enableColumnarOutput - Enables writing the records to a binary columnar file as well as to the CSV file.
+**********************/
+void AgentsDataRecorder::enableColumnarOutput(std::string fileName, uint64_t parametersHash, uint64_t seed)
+{
+    isColumnarOutputEnabled = true;
+    columnarFileName = fileName;
+    columnarParametersHash = parametersHash;
+    columnarSeed = seed;
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::record - Gets the values of all data sources on this process and starts summing them onto rank 0, or onto all processes
+*   when the termination criteria need them. The previous record is completed first, as its buffers are reused.
+**********************/
+void AgentsDataRecorder::record()
+{
+    completeReduction();
+
+    for( size_t i = 0; i < dataSources.size(); ++i )
+    {
+        localValues[i] = dataSources[i]->getData();
+    }
+
+    tickInFlight = repast::RepastProcess::instance()->getScheduleRunner().currentTick();
+    if( terminationCriteria != nullptr )
+    {
+        MPI_Iallreduce(localValues.data(), summedValues.data(), localValues.size(), MPI_LONG_LONG, MPI_SUM, recorderComm, &reductionRequest);
+    }
+    else
+    {
+        MPI_Ireduce(localValues.data(), summedValues.data(), localValues.size(), MPI_LONG_LONG, MPI_SUM, 0, recorderComm, &reductionRequest);
+    }
+    isReductionInFlight = true;
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::completeReduction - Waits for the reduction in flight, if there is one, and passes its sums on rank 0 to the writer thread,
+*   keeping a copy of them if the records are retained. Then the termination criteria are checked on the sums, on all processes.
+**********************/
+void AgentsDataRecorder::completeReduction()
+{
+    if( !isReductionInFlight )
+    {
+        return;
+    }
+
+    MPI_Wait(&reductionRequest, MPI_STATUS_IGNORE);
+    isReductionInFlight = false;
+
+    if( rank == 0 )
+    {
+        AgentsDataQueueItem recordItem;
+        recordItem.kind = AgentsDataQueueItem::Record;
+        recordItem.tick = tickInFlight;
+        recordItem.values = summedValues;
+        writerQueue.push(recordItem);
+
+        if( isRetainingRecords )
+        {
+            retainedTicks.push_back(tickInFlight);
+            retainedValues.insert(retainedValues.end(), summedValues.begin(), summedValues.end());
+        }
+    }
+
+    if( terminationCriteria != nullptr )
+    {
+        terminationCriteria->check(tickInFlight, summedValues);
+    }
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::shareRetainedRecords - Completes the record in flight, then broadcasts the records retained on rank 0 to the other processes,
+*   so the embedding program can read them on any process. No reduction is in flight afterwards, so the broadcasts cannot be mixed up with one.
+**********************/
+void AgentsDataRecorder::shareRetainedRecords()
+{
+    completeReduction();
+
+    int recordsCount = retainedTicks.size();
+    MPI_Bcast(&recordsCount, 1, MPI_INT, 0, recorderComm);
+    retainedTicks.resize(recordsCount);
+    retainedValues.resize(recordsCount * columnNames.size());
+    if( recordsCount > 0 )
+    {
+        MPI_Bcast(retainedTicks.data(), recordsCount, MPI_DOUBLE, 0, recorderComm);
+        MPI_Bcast(retainedValues.data(), retainedValues.size(), MPI_LONG_LONG, 0, recorderComm);
+    }
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::write - Asks the writer thread to write all records completed so far. Returns without waiting for the writing.
+**********************/
+void AgentsDataRecorder::write()
+{
+    completeReduction();
+
+    if( rank == 0 )
+    {
+        AgentsDataQueueItem writeItem;
+        writeItem.kind = AgentsDataQueueItem::Write;
+        writerQueue.push(writeItem);
+    }
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::restart - Completes the reduction in flight and stops the writer thread once it has handled everything queued before,
+*   then starts recording into the passed file with the same columns. The retained records are dropped, but the later ones are still retained.
+*   The columnar output needs to be enabled again, for the new run.
+**********************/
+void AgentsDataRecorder::restart(std::string fileName)
+{
+    completeReduction();
+
+    if( writerThread.joinable() )
+    {
+        AgentsDataQueueItem stopItem;
+        stopItem.kind = AgentsDataQueueItem::Stop;
+        writerQueue.push(stopItem);
+        writerThread.join();
+    }
+
+    recordedTicks.clear();
+    recordedValues.clear();
+    retainedTicks.clear();
+    retainedValues.clear();
+    output.close();
+    output.clear();
+    outputFileName = fileName;
+
+    isColumnarOutputEnabled = false;
+    delete columnarOutput;
+    columnarOutput = nullptr;
+
+    if( rank == 0 )
+    {
+        writerThread = std::thread(&AgentsDataRecorder::runWriterThread, this);
+    }
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::runWriterThread - The loop of the writer thread. Collects the records from the queue and writes them when asked to,
+*   until it is asked to stop. It sleeps briefly whenever the queue is empty, as the records only arrive once per timestep.
+**********************/
+void AgentsDataRecorder::runWriterThread()
+{
+    AgentsDataQueueItem item;
+    while( true )
+    {
+        if( !writerQueue.tryPop(item) )
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        if( item.kind == AgentsDataQueueItem::Record )
+        {
+            recordedTicks.push_back(item.tick);
+            recordedValues.insert(recordedValues.end(), item.values.begin(), item.values.end());
+        }
+        else if( item.kind == AgentsDataQueueItem::Write )
+        {
+            writeRecordedValues();
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+
+
+/**********************
+*   AgentsDataRecorder::writeRecordedValues - Writes the records received so far to the file, in the same layout as the Repast SV data sets: 
+*   a header row with the tick and the column names, then one row per recorded tick. If enabled, they are also appended to the columnar file.
+*   Both files are then synced to disk, so a write is durable by the time the next one starts.
+**********************/
+void AgentsDataRecorder::writeRecordedValues()
+{
+    if( !output.is_open() )
+    {
+        output.open(outputFileName.c_str());
+        output<<"tick";
+        for( size_t i = 0; i < columnNames.size(); ++i )
+        {
+            output<<","<<columnNames[i];
+        }
+        output<<std::endl;
+    }
+
+    size_t columnsCount = columnNames.size();
+    for( size_t r = 0; r < recordedTicks.size(); ++r )
+    {
+        output<<recordedTicks[r];
+        for( size_t i = 0; i < columnsCount; ++i )
+        {
+            output<<","<<recordedValues[r * columnsCount + i];
+        }
+        output<<"\n";
+    }
+    output.flush();
+    syncFileToDisk(outputFileName);
+
+    if( isColumnarOutputEnabled )
+    {
+        if( columnarOutput == nullptr )
+        {
+            columnarOutput = new ColumnarTimeSeriesWriter(columnarFileName, columnarParametersHash, columnarSeed, columnNames);
+        }
+        columnarOutput->appendChunk(recordedTicks, recordedValues);
+        syncFileToDisk(columnarFileName);
+    }
+
+    recordedTicks.clear();
+    recordedValues.clear();
+}
@@ -0,0 +1,160 @@
+/* Ensemble_Runner.cpp */
+// Implements the running of many replicas of the simulation concurrently, on groups of the processes of one MPI job.
+
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+#include "repast_hpc/RepastProcess.h"
+
+#include "Ensemble_Runner.h"
+#include "Process_Grid_Mapping.h"
+#include "Virus_Cell_Model.h"
+
+
+/**********************
+*   EnsembleRunner::EnsembleRunner - Constructor. Keeps the arguments needed to create the models of the replicas.
+**********************/
+EnsembleRunner::EnsembleRunner(std::string theConfigFile, std::string thePropsFile, int theArgc, char** theArgv):
+configFile(theConfigFile),
+propsFile(thePropsFile),
+argc(theArgc),
+argv(theArgv)
+{
+}
+
+
+
+/**********************
+*   EnsembleRunner::createReplicaJobs - Creates the jobs of plain replicas, which only differ in their random seeds.
+**********************/
+std::vector<EnsembleJob> EnsembleRunner::createReplicaJobs(int jobsCount, int baseSeed)
+{
+    std::vector<EnsembleJob> jobs(std::max(0, jobsCount));
+    for( int j = 0; j < jobsCount; ++j )
+    {
+        jobs[j].name = "replica_" + std::to_string(j);
+        jobs[j].seed = baseSeed + j;
+    }
+
+    return jobs;
+}
+
+
+
+/**********************
+*   EnsembleRunner::run - Splits the processes into the groups and has each group run jobs until all have been taken. The processes left over
+*   when the count of processes is not a multiple of the size of a group only take part in creating and freeing the job counter.
+**********************/
+void EnsembleRunner::run(boost::mpi::communicator& world, int concurrentReplicas, const std::vector<EnsembleJob>& jobs, std::string outputDirectory,
+                         int processesCountXAxis, int processesCountYAxis, bool isNodeAware, bool isModelReused)
+{
+    int jobsCount = jobs.size();
+    int groupSize = processesCountXAxis * processesCountYAxis;
+    if( concurrentReplicas < 1 || groupSize * concurrentReplicas > world.size() )
+    {
+        if( world.rank() == 0 )
+        {
+            std::cout<<"The ensemble needs "<<groupSize<<" processes for each of its "<<concurrentReplicas<<" concurrent replicas, but there are "
+                <<world.size()<<" processes!"<<std::endl;
+        }
+        return;
+    }
+
+    // The counter of the jobs handed out lives on process 0. The other processes expose no memory in the window.
+    int nextJob = 0;
+    MPI_Win jobCounterWindow;
+    MPI_Win_create(&nextJob, (world.rank() == 0) ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, world, &jobCounterWindow);
+
+    int group = world.rank() / groupSize;
+    if( group < concurrentReplicas )
+    {
+        boost::mpi::communicator groupComm = world.split(group);
+        boost::mpi::communicator modelComm(ProcessGridMapping::createModelCommunicator(groupComm, processesCountXAxis, processesCountYAxis, isNodeAware, false), 
+            boost::mpi::comm_take_ownership);
+
+        VirusCellModel* model = nullptr;
+        while( true )
+        {
+            int job = 0;
+            if( modelComm.rank() == 0 )
+            {
+                int increment = 1;
+                MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, jobCounterWindow);
+                MPI_Fetch_and_op(&increment, &job, MPI_INT, 0, 0, MPI_SUM, jobCounterWindow);
+                MPI_Win_unlock(0, jobCounterWindow);
+            }
+            boost::mpi::broadcast(modelComm, job, 0);
+            if( job >= jobsCount )
+            {
+                break;
+            }
+
+            if( modelComm.rank() == 0 )
+            {
+                std::cout<<"Ensemble: group "<<group<<" runs job "<<job<<" of "<<jobsCount<<" ("<<jobs[job].name<<") with the random seed "<<jobs[job].seed<<std::endl;
+            }
+            runReplica(modelComm, jobs[job], outputDirectory + "/" + jobs[job].name, processesCountXAxis, processesCountYAxis, model);
+
+            if( !isModelReused )
+            {
+                delete model;
+                model = nullptr;
+                repast::RepastProcess::instance()->done();
+            }
+        }
+
+        if( model != nullptr )
+        {
+            delete model;
+            repast::RepastProcess::instance()->done();
+        }
+    }
+    else
+    {
+        world.split(MPI_UNDEFINED);
+        std::cout<<"Ensemble: process "<<world.rank()<<" is not in any group and stays idle."<<std::endl;
+    }
+
+    MPI_Win_free(&jobCounterWindow);
+}
+
+
+
+/**********************
+*   EnsembleRunner::runReplica - Runs one replica on the group. Without a model from the previous replica, a new Repast process and model are created,
+*   as for the calibration runs of the process grid autotuning. Otherwise the model is reset for the replica, and only the Repast process is created
+*   again, for a fresh schedule. The model is left for the caller to reuse or delete.
+**********************/
+void EnsembleRunner::runReplica(boost::mpi::communicator& modelComm, const EnsembleJob& job, std::string replicaDirectory, int processesCountXAxis, int processesCountYAxis,
+                                VirusCellModel*& model)
+{
+    if( modelComm.rank() == 0 )
+    {
+        mkdir(replicaDirectory.c_str(), 0755);
+    }
+    modelComm.barrier();
+
+    std::map<std::string, std::string> propertyOverrides(job.propertyOverrides);
+    propertyOverrides["output.directory"] = replicaDirectory;
+    propertyOverrides["count.of.processes.X.axis"] = std::to_string(processesCountXAxis);
+    propertyOverrides["count.of.processes.Y.axis"] = std::to_string(processesCountYAxis);
+
+    if( model != nullptr )
+    {
+        model->reset(propertyOverrides, job.seed);
+        repast::RepastProcess::instance()->done();
+        repast::RepastProcess::init(configFile, &modelComm);
+    }
+    else
+    {
+        propertyOverrides["random.seed"] = std::to_string(job.seed);
+        repast::RepastProcess::init(configFile, &modelComm);
+        model = new VirusCellModel(propsFile, argc, argv, &modelComm, &propertyOverrides);
+    }
+
+    repast::ScheduleRunner& runner = repast::RepastProcess::instance()->getScheduleRunner();
+    model->init();
+    model->initSchedule(runner);
+
+    runner.run();
+}
@@ -6,6 +6,7 @@
 **********************/
 #include "Epithelial_Cell_Agent.h"
 #include "Virus_Cell_Agent.h"
+#include "Population_Counters.h"
 #include "repast_hpc/Moore2DGridQuery.h"
 #include "repast_hpc/Point.h"
 
@@ -34,6 +35,7 @@ virionReleaseRate(theVirionReleaseRate),
 countOfVirionsToRelease(0),
 virionReleaseRemainder(0.0)
 {
+    PopulationCounters::instance()->epithelialCellAdded(agentId.currentRank(), internalState);
 }
 
 
@@ -64,7 +66,7 @@ virionReleaseRate(theVirionReleaseRate),
 countOfVirionsToRelease(theCountOfVirionsToRelease),
 virionReleaseRemainder(theVirionReleaseRemainder)
 {
-
+    PopulationCounters::instance()->epithelialCellAdded(agentId.currentRank(), internalState);
 }
 
 
@@ -91,7 +93,7 @@ void EpithelialCellAgent::set(int currentRank, double newLifespan, double newAge
     agentId.currentRank(currentRank);
     agentLifespan = newLifespan;
     agentAge = newAge;
-    internalState = newInternalState;
+    changeInternalState(newInternalState);
     externalState = newExtState;
     infectedLifespan = newInfectedLifespan;
     timeInfected = newInfectedTime;
@@ -110,6 +112,18 @@ void EpithelialCellAgent::set(int currentRank, double newLifespan, double newAge
 
 
 
+/**********************
+*   EpithelialCellAgent::changeInternalState - Changes the internal state of the cell. All changes of the internal state of an original cell go through here,
+*   so the counts of the cells in each state kept by the population counters stay exact. The copies in the buffer zones are not counted.
+**********************/
+void EpithelialCellAgent::changeInternalState(InternalState newInternalState)
+{
+    PopulationCounters::instance()->epithelialCellStateChanged(agentId.currentRank(), internalState, newInternalState);
+    internalState = newInternalState;
+}
+
+
+
 /**********************
 *   EpithelialCellAgent::doStep - Function for an agent to do a step. Will be triggered on every step,
 *   The agent will then do an action depending on the surrounding agents and its internal state.
@@ -126,7 +140,7 @@ void EpithelialCellAgent::doStep(repast::SharedContext<VirusCellInteractionAgent
     // If the age exceeds the cell's lifespan, the cell dies. Change both internal and external cell states to dead.
     if(agentAge > agentLifespan && internalState != Dead)
     {
-        internalState = Dead;
+        changeInternalState(Dead);
         externalState = DeadCell;
     }
 
@@ -148,6 +162,51 @@ void EpithelialCellAgent::doStep(repast::SharedContext<VirusCellInteractionAgent
 
 
 
+/**********************
+*   EpithelialCellAgent::advanceBufferZoneCopy - Advances a copy of the agent in the buffer zone by one step, when the buffer zone is not
+*   synchronised on every step. Repeats the part of doStep which does not depend on random numbers or on other agents: the ageing, the death
+*   at the end of the lifespan, the progress of an infection and the division timer. The stochastic actions are only taken by the original agent.
+*   The copies are only read for their external state, and the original's process checks the state of a cell before modifying it, 
+*   so any event the copy misses until the next synchronisation can only make a neighbour skip a modification, never apply a wrong one.
+**********************/
+void EpithelialCellAgent::advanceBufferZoneCopy()
+{
+    countOfVirionsToRelease = 0;
+    modificationToNeighbCell = NoModification;
+    neighbouringCellToModify = idForNoNeighbourModification;
+
+    ++agentAge;
+    if(agentAge > agentLifespan && internalState != Dead)
+    {
+        internalState = Dead;
+        externalState = DeadCell;
+    }
+
+    if( internalState == Infected )
+    {
+        ++timeInfected;
+        if( timeInfected > infectedLifespan )
+        {
+            internalState = Dead;
+            externalState = DeadCell;
+        }
+        else if( timeInfected > displayVirProteinsDelay || timeInfected > releaseDelay )
+        {
+            externalState = DisplayingViralProtein;
+        }
+    }
+    else if( internalState == Healthy )
+    {
+        ++timeSinceLastDivision;
+        if( timeSinceLastDivision > divisionRate )
+        {
+            timeSinceLastDivision = 0;
+        }
+    }
+}
+
+
+
 /**********************
 *   EpithelialCellAgent::actHealthy - If the epithelial cell agent is heallthy, then act normally.
 *   Track its division rate and if it is ready to divide, choose a neighbouring cell to divide into.
@@ -220,7 +279,7 @@ void EpithelialCellAgent::actInfected(repast::SharedDiscreteSpace<VirusCellInter
     // Then return since a dead cell cannot perform any further actions.
     if( timeInfected > infectedLifespan )
     {
-        internalState = Dead;
+        changeInternalState(Dead);
         externalState = DeadCell;
         return;
     }
@@ -0,0 +1,242 @@
+/* Infection_Front.cpp */
+// Implements the in-situ tracking of the infection front around each focus.
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <boost/algorithm/string/trim.hpp>
+
+#include "Infection_Front.h"
+
+
+static const int momentsPerFocus = 4;
+static const double pi = 3.14159265358979323846;
+
+
+/**********************
+*   InfectionFrontTracker::InfectionFrontTracker - Constructor. Without any foci given, a single focus is tracked once it has been anchored.
+**********************/
+InfectionFrontTracker::InfectionFrontTracker(boost::mpi::communicator* comm, int theGridSizeX, int theGridSizeY, const std::vector<std::pair<int, int> >& foci,
+                                             int theVelocityWindow):
+gridSizeX(theGridSizeX),
+gridSizeY(theGridSizeY),
+fociSites(foci),
+areFociGiven(!foci.empty()),
+isFocusAnchored(!foci.empty()),
+velocityWindow(std::max(2, theVelocityWindow))
+{
+    MPI_Comm_dup(*comm, &trackerComm);
+
+    if( fociSites.empty() )
+    {
+        fociSites.push_back(std::make_pair(0, 0));
+    }
+
+    reset();
+}
+
+
+
+/**********************
+*   InfectionFrontTracker::reset - Clears the results of all foci and their sliding windows.
+**********************/
+void InfectionFrontTracker::reset()
+{
+    isFocusAnchored = areFociGiven;
+    infectedSites.clear();
+
+    int fociCount = fociSites.size();
+    infectedCounts.assign(fociCount, 0);
+    centroidsX.assign(fociCount, 0.0);
+    centroidsY.assign(fociCount, 0.0);
+    radiiOfGyration.assign(fociCount, 0.0);
+    maxInfectedRadii.assign(fociCount, 0.0);
+    frontVelocities.assign(fociCount, 0.0);
+    radiusHistories.assign(fociCount, std::deque<std::pair<int, double> >());
+}
+
+
+
+/**********************
+*   InfectionFrontTracker::~InfectionFrontTracker - Destructor. Frees the communicator.
+**********************/
+InfectionFrontTracker::~InfectionFrontTracker()
+{
+    MPI_Comm_free(&trackerComm);
+}
+
+
+
+/**********************
+*   InfectionFrontTracker::getWrappedOffset - Gets the offset of the coordinate from the anchor coordinate, the shortest way around the grid.
+**********************/
+double InfectionFrontTracker::getWrappedOffset(int coordinate, int anchorCoordinate, int gridSize) const
+{
+    double offset = coordinate - anchorCoordinate;
+    return offset - gridSize * std::floor(offset / gridSize + 0.5);
+}
+
+
+
+/**********************
+*   InfectionFrontTracker::anchorFocusAtCircularMean - Anchors the focus at the circular mean of the infected sites of all processes, once there are any.
+*   Each coordinate is taken as an angle around its axis of the grid, so the mean is correct even for infections which cross the edges of the grid.
+**********************/
+void InfectionFrontTracker::anchorFocusAtCircularMean()
+{
+    double circularMoments[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for( size_t i = 0; i < infectedSites.size(); ++i )
+    {
+        double angleX = 2.0 * pi * infectedSites[i].first / gridSizeX;
+        double angleY = 2.0 * pi * infectedSites[i].second / gridSizeY;
+        circularMoments[0] += 1.0;
+        circularMoments[1] += std::cos(angleX);
+        circularMoments[2] += std::sin(angleX);
+        circularMoments[3] += std::cos(angleY);
+        circularMoments[4] += std::sin(angleY);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, circularMoments, 5, MPI_DOUBLE, MPI_SUM, trackerComm);
+    if( circularMoments[0] == 0.0 )
+    {
+        return;
+    }
+
+    int anchorX = static_cast<int>(std::lround(std::atan2(circularMoments[2], circularMoments[1]) / (2.0 * pi) * gridSizeX));
+    int anchorY = static_cast<int>(std::lround(std::atan2(circularMoments[4], circularMoments[3]) / (2.0 * pi) * gridSizeY));
+    fociSites[0] = std::make_pair((anchorX + gridSizeX) % gridSizeX, (anchorY + gridSizeY) % gridSizeY);
+    isFocusAnchored = true;
+}
+
+
+
+/**********************
+*   InfectionFrontTracker::completeTick - Adds up the moments of the infected sites of this process around their nearest foci, combines them
+*   over all processes in one reduction, and derives the centroid, radius of gyration, maximal infected radius and front velocity of each focus.
+**********************/
+void InfectionFrontTracker::completeTick(int tick)
+{
+    if( !isFocusAnchored )
+    {
+        anchorFocusAtCircularMean();
+        if( !isFocusAnchored )
+        {
+            return;
+        }
+    }
+
+    int fociCount = fociSites.size();
+    std::vector<double> moments((momentsPerFocus + 1) * fociCount, 0.0);
+    for( size_t i = 0; i < infectedSites.size(); ++i )
+    {
+        int nearestFocus = 0;
+        double nearestOffsetX = 0.0;
+        double nearestOffsetY = 0.0;
+        double nearestDistanceSquared = -1.0;
+        for( int f = 0; f < fociCount; ++f )
+        {
+            double offsetX = getWrappedOffset(infectedSites[i].first, fociSites[f].first, gridSizeX);
+            double offsetY = getWrappedOffset(infectedSites[i].second, fociSites[f].second, gridSizeY);
+            double distanceSquared = offsetX * offsetX + offsetY * offsetY;
+            if( nearestDistanceSquared < 0.0 || distanceSquared < nearestDistanceSquared )
+            {
+                nearestFocus = f;
+                nearestOffsetX = offsetX;
+                nearestOffsetY = offsetY;
+                nearestDistanceSquared = distanceSquared;
+            }
+        }
+
+        double* focusMoments = &moments[momentsPerFocus * nearestFocus];
+        focusMoments[0] += 1.0;
+        focusMoments[1] += nearestOffsetX;
+        focusMoments[2] += nearestOffsetY;
+        focusMoments[3] += nearestDistanceSquared;
+
+        double& largestDistanceSquared = moments[momentsPerFocus * fociCount + nearestFocus];
+        largestDistanceSquared = std::max(largestDistanceSquared, nearestDistanceSquared);
+    }
+
+    // The moments of all foci are summed and their largest squared distances are maxed, in two reductions in flight together.
+    MPI_Request reductionRequests[2];
+    MPI_Iallreduce(MPI_IN_PLACE, moments.data(), momentsPerFocus * fociCount, MPI_DOUBLE, MPI_SUM, trackerComm, &reductionRequests[0]);
+    MPI_Iallreduce(MPI_IN_PLACE, moments.data() + momentsPerFocus * fociCount, fociCount, MPI_DOUBLE, MPI_MAX, trackerComm, &reductionRequests[1]);
+    MPI_Waitall(2, reductionRequests, MPI_STATUSES_IGNORE);
+
+    for( int f = 0; f < fociCount; ++f )
+    {
+        const double* focusMoments = &moments[momentsPerFocus * f];
+        infectedCounts[f] = static_cast<int>(focusMoments[0]);
+        if( infectedCounts[f] > 0 )
+        {
+            // The offsets are all taken the shortest way from the anchor, so the plain moments around the anchor give the centroid and spread.
+            double meanOffsetX = focusMoments[1] / focusMoments[0];
+            double meanOffsetY = focusMoments[2] / focusMoments[0];
+            centroidsX[f] = std::fmod(fociSites[f].first + meanOffsetX + gridSizeX, gridSizeX);
+            centroidsY[f] = std::fmod(fociSites[f].second + meanOffsetY + gridSizeY, gridSizeY);
+            radiiOfGyration[f] = std::sqrt(std::max(0.0, focusMoments[3] / focusMoments[0] - meanOffsetX * meanOffsetX - meanOffsetY * meanOffsetY));
+            maxInfectedRadii[f] = std::sqrt(moments[momentsPerFocus * fociCount + f]);
+        }
+        else
+        {
+            centroidsX[f] = fociSites[f].first;
+            centroidsY[f] = fociSites[f].second;
+            radiiOfGyration[f] = 0.0;
+            maxInfectedRadii[f] = 0.0;
+        }
+
+        // Fit the slope of the maximal infected radius over the ticks in the window.
+        std::deque<std::pair<int, double> >& history = radiusHistories[f];
+        history.push_back(std::make_pair(tick, maxInfectedRadii[f]));
+        while( history.back().first - history.front().first >= velocityWindow )
+        {
+            history.pop_front();
+        }
+
+        double meanTick = 0.0;
+        double meanRadius = 0.0;
+        for( size_t h = 0; h < history.size(); ++h )
+        {
+            meanTick += history[h].first;
+            meanRadius += history[h].second;
+        }
+        meanTick /= history.size();
+        meanRadius /= history.size();
+
+        double covariance = 0.0;
+        double tickVariance = 0.0;
+        for( size_t h = 0; h < history.size(); ++h )
+        {
+            covariance += (history[h].first - meanTick) * (history[h].second - meanRadius);
+            tickVariance += (history[h].first - meanTick) * (history[h].first - meanTick);
+        }
+        frontVelocities[f] = (tickVariance > 0.0) ? covariance / tickVariance : 0.0;
+    }
+}
+
+
+
+/**********************
+*   InfectionFrontTracker::parseFoci - Parses a comma separated list of sites, each as x:y, e.g. "0:0, 50:-50". Anything which is not a site is ignored.
+**********************/
+std::vector<std::pair<int, int> > InfectionFrontTracker::parseFoci(const std::string& fociList)
+{
+    std::vector<std::pair<int, int> > foci;
+
+    std::stringstream listStream(fociList);
+    std::string site;
+    while( std::getline(listStream, site, ',') )
+    {
+        boost::algorithm::trim(site);
+
+        std::stringstream siteStream(site);
+        int x, y;
+        char separator;
+        if( siteStream >> x >> separator >> y && separator == ':' && siteStream.eof() )
+        {
+            foci.push_back(std::make_pair(x, y));
+        }
+    }
+
+    return foci;
+}
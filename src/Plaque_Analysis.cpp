@@ -0,0 +1,328 @@
+/* Plaque_Analysis.cpp */
+// Implements the in-situ labelling and measuring of the infection plaques over the distributed grid.
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Plaque_Analysis.h"
+
+
+/**********************
+*   findEdgeRoot - Finds the root of an edge plaque's tree in the union-find of rank 0, halving the path on the way.
+**********************/
+static int findEdgeRoot(std::vector<int>& edgeParents, int plaque)
+{
+    while( edgeParents[plaque] != plaque )
+    {
+        edgeParents[plaque] = edgeParents[edgeParents[plaque]];
+        plaque = edgeParents[plaque];
+    }
+
+    return plaque;
+}
+
+
+/**********************
+*   PlaqueAnalysis::PlaqueAnalysis - Constructor. Sizes the size distribution so that its last bin holds a plaque covering the whole grid.
+**********************/
+PlaqueAnalysis::PlaqueAnalysis(boost::mpi::communicator* comm, ProcessNeighbourhood* theProcessNeighbourhood, int theGridSizeX, int theGridSizeY,
+                               int theLocalStartX, int theLocalStartY, int theLocalSizeX, int theLocalSizeY):
+processNeighbourhood(theProcessNeighbourhood),
+gridSizeX(theGridSizeX),
+gridSizeY(theGridSizeY),
+localStartX(theLocalStartX),
+localStartY(theLocalStartY),
+localSizeX(theLocalSizeX),
+localSizeY(theLocalSizeY),
+plaqueCount(0),
+largestPlaqueArea(0)
+{
+    MPI_Comm_dup(*comm, &analysisComm);
+    MPI_Comm_rank(analysisComm, &rank);
+
+    siteParents.resize(localSizeX * localSizeY);
+    outgoingBoundarySites.resize(processNeighbourhood->getNeighbourCount());
+    plaqueSizeDistribution.resize(getSizeBin(static_cast<long long>(gridSizeX) * gridSizeY) + 1, 0);
+}
+
+
+
+/**********************
+*   PlaqueAnalysis::~PlaqueAnalysis - Destructor. Frees the communicator.
+**********************/
+PlaqueAnalysis::~PlaqueAnalysis()
+{
+    MPI_Comm_free(&analysisComm);
+}
+
+
+
+/**********************
+*   PlaqueAnalysis::findRoot - Finds the root of the local site's tree, halving the path on the way.
+**********************/
+int PlaqueAnalysis::findRoot(int site)
+{
+    while( siteParents[site] != site )
+    {
+        siteParents[site] = siteParents[siteParents[site]];
+        site = siteParents[site];
+    }
+
+    return site;
+}
+
+
+
+/**********************
+*   PlaqueAnalysis::isLocalSite - Checks whether the site at the passed grid coordinates is in this process's section.
+**********************/
+bool PlaqueAnalysis::isLocalSite(int x, int y) const
+{
+    return x >= localStartX && x < localStartX + localSizeX && y >= localStartY && y < localStartY + localSizeY;
+}
+
+
+
+/**********************
+*   PlaqueAnalysis::getSizeBin - Finds the bin of the size distribution for a plaque of the passed size: floor(log2(size)).
+**********************/
+int PlaqueAnalysis::getSizeBin(long long plaqueSize) const
+{
+    int bin = 0;
+    while( plaqueSize > 1 )
+    {
+        plaqueSize >>= 1;
+        ++bin;
+    }
+
+    return bin;
+}
+
+
+
+/**********************
+*   PlaqueAnalysis::analyse - Labels the plaques of this process's section, merges the ones crossing the section boundaries on rank 0,
+*   and counts and measures all of them. Neighbouring sites are found on the wraparound grid, so when the section spans the whole grid
+*   on an axis, the plaques wrapping around on that axis are joined locally.
+**********************/
+void PlaqueAnalysis::analyse(const std::vector<unsigned char>& isPlaqueSite)
+{
+    int localSitesCount = localSizeX * localSizeY;
+    for( int site = 0; site < localSitesCount; ++site )
+    {
+        siteParents[site] = site;
+    }
+
+    // Join each plaque site with the plaque sites around it in this section.
+    for( int site = 0; site < localSitesCount; ++site )
+    {
+        if( !isPlaqueSite[site] )
+        {
+            continue;
+        }
+
+        int x = localStartX + site / localSizeY;
+        int y = localStartY + site % localSizeY;
+        for( int dx = -1; dx <= 1; ++dx )
+        {
+            for( int dy = -1; dy <= 1; ++dy )
+            {
+                int neighbourX = (x + dx + gridSizeX) % gridSizeX;
+                int neighbourY = (y + dy + gridSizeY) % gridSizeY;
+                if( !isLocalSite(neighbourX, neighbourY) )
+                {
+                    continue;
+                }
+
+                int neighbourSite = (neighbourX - localStartX) * localSizeY + (neighbourY - localStartY);
+                if( isPlaqueSite[neighbourSite] )
+                {
+                    int siteRoot = findRoot(site);
+                    int neighbourRoot = findRoot(neighbourSite);
+                    if( siteRoot != neighbourRoot )
+                    {
+                        siteParents[std::max(siteRoot, neighbourRoot)] = std::min(siteRoot, neighbourRoot);
+                    }
+                }
+            }
+        }
+    }
+
+    // Measure the local plaques and note the ones which reach the edge of the section, as they may continue on a neighbouring process.
+    // Send the edge sites of the plaques to the neighbouring processes whose sites touch them.
+    std::vector<int> rootSizes(localSitesCount, 0);
+    std::vector<bool> isRootOnEdge(localSitesCount, false);
+    for( size_t n = 0; n < outgoingBoundarySites.size(); ++n )
+    {
+        outgoingBoundarySites[n].clear();
+    }
+
+    for( int site = 0; site < localSitesCount; ++site )
+    {
+        if( !isPlaqueSite[site] )
+        {
+            continue;
+        }
+
+        int root = findRoot(site);
+        ++rootSizes[root];
+
+        int localX = site / localSizeY;
+        int localY = site % localSizeY;
+        if( localX != 0 && localX != localSizeX - 1 && localY != 0 && localY != localSizeY - 1 )
+        {
+            continue;
+        }
+        isRootOnEdge[root] = true;
+
+        PlaqueBoundarySite boundarySite;
+        boundarySite.x = localStartX + localX;
+        boundarySite.y = localStartY + localY;
+        boundarySite.label = static_cast<long long>(rank) * localSitesCount + root;
+
+        int sentToNeighbours[9];
+        int sentCount = 0;
+        for( int dx = -1; dx <= 1; ++dx )
+        {
+            for( int dy = -1; dy <= 1; ++dy )
+            {
+                int directionX = (localX + dx < 0) ? -1 : ((localX + dx >= localSizeX) ? 1 : 0);
+                int directionY = (localY + dy < 0) ? -1 : ((localY + dy >= localSizeY) ? 1 : 0);
+                int neighbourIndex = processNeighbourhood->getNeighbourIndexInDirection(directionX, directionY);
+                if( (directionX == 0 && directionY == 0) || neighbourIndex < 0 || std::find(sentToNeighbours, sentToNeighbours + sentCount, neighbourIndex) != sentToNeighbours + sentCount )
+                {
+                    continue;
+                }
+
+                sentToNeighbours[sentCount++] = neighbourIndex;
+                outgoingBoundarySites[neighbourIndex].push_back(boundarySite);
+            }
+        }
+    }
+
+    processNeighbourhood->exchange(outgoingBoundarySites, incomingBoundarySites);
+
+    // Pair the labels of the plaques touching across the section boundaries.
+    std::vector<long long> touchingLabels;
+    for( size_t i = 0; i < incomingBoundarySites.size(); ++i )
+    {
+        for( int dx = -1; dx <= 1; ++dx )
+        {
+            for( int dy = -1; dy <= 1; ++dy )
+            {
+                int neighbourX = (incomingBoundarySites[i].x + dx + gridSizeX) % gridSizeX;
+                int neighbourY = (incomingBoundarySites[i].y + dy + gridSizeY) % gridSizeY;
+                if( !isLocalSite(neighbourX, neighbourY) )
+                {
+                    continue;
+                }
+
+                int neighbourSite = (neighbourX - localStartX) * localSizeY + (neighbourY - localStartY);
+                if( isPlaqueSite[neighbourSite] )
+                {
+                    touchingLabels.push_back(static_cast<long long>(rank) * localSitesCount + findRoot(neighbourSite));
+                    touchingLabels.push_back(incomingBoundarySites[i].label);
+                }
+            }
+        }
+    }
+
+    // The plaques within the section are complete and counted here. The ones on the edge are passed to rank 0 as (label, size) pairs.
+    std::vector<int> localCounts(plaqueSizeDistribution.size() + 1, 0);
+    int localLargestArea = 0;
+    std::vector<long long> edgePlaques;
+    for( int root = 0; root < localSitesCount; ++root )
+    {
+        if( rootSizes[root] == 0 )
+        {
+            continue;
+        }
+
+        if( isRootOnEdge[root] )
+        {
+            edgePlaques.push_back(static_cast<long long>(rank) * localSitesCount + root);
+            edgePlaques.push_back(rootSizes[root]);
+        }
+        else
+        {
+            ++localCounts[0];
+            ++localCounts[1 + getSizeBin(rootSizes[root])];
+            localLargestArea = std::max(localLargestArea, rootSizes[root]);
+        }
+    }
+
+    std::vector<int> totalCounts(localCounts.size(), 0);
+    MPI_Reduce(localCounts.data(), totalCounts.data(), localCounts.size(), MPI_INT, MPI_SUM, 0, analysisComm);
+    MPI_Reduce(&localLargestArea, &largestPlaqueArea, 1, MPI_INT, MPI_MAX, 0, analysisComm);
+
+    int sizes[2] = { static_cast<int>(edgePlaques.size()), static_cast<int>(touchingLabels.size()) };
+    int processesCount;
+    MPI_Comm_size(analysisComm, &processesCount);
+    std::vector<int> allSizes(rank == 0 ? 2 * processesCount : 0);
+    MPI_Gather(sizes, 2, MPI_INT, allSizes.data(), 2, MPI_INT, 0, analysisComm);
+
+    std::vector<int> edgePlaqueCounts(processesCount, 0), edgePlaqueDispls(processesCount, 0);
+    std::vector<int> touchingCounts(processesCount, 0), touchingDispls(processesCount, 0);
+    std::vector<long long> allEdgePlaques;
+    std::vector<long long> allTouchingLabels;
+    if( rank == 0 )
+    {
+        for( int r = 0; r < processesCount; ++r )
+        {
+            edgePlaqueCounts[r] = allSizes[2 * r];
+            touchingCounts[r] = allSizes[2 * r + 1];
+            if( r > 0 )
+            {
+                edgePlaqueDispls[r] = edgePlaqueDispls[r - 1] + edgePlaqueCounts[r - 1];
+                touchingDispls[r] = touchingDispls[r - 1] + touchingCounts[r - 1];
+            }
+        }
+        allEdgePlaques.resize(edgePlaqueDispls[processesCount - 1] + edgePlaqueCounts[processesCount - 1]);
+        allTouchingLabels.resize(touchingDispls[processesCount - 1] + touchingCounts[processesCount - 1]);
+    }
+    MPI_Gatherv(edgePlaques.data(), sizes[0], MPI_LONG_LONG, allEdgePlaques.data(), edgePlaqueCounts.data(), edgePlaqueDispls.data(), MPI_LONG_LONG, 0, analysisComm);
+    MPI_Gatherv(touchingLabels.data(), sizes[1], MPI_LONG_LONG, allTouchingLabels.data(), touchingCounts.data(), touchingDispls.data(), MPI_LONG_LONG, 0, analysisComm);
+
+    if( rank != 0 )
+    {
+        return;
+    }
+
+    // Merge the edge plaques which touch across the boundaries, then add them to the counts of the complete plaques.
+    std::unordered_map<long long, int> indexOfLabel;
+    std::vector<int> edgeParents(allEdgePlaques.size() / 2);
+    std::vector<long long> edgeSizes(allEdgePlaques.size() / 2, 0);
+    for( size_t p = 0; p < edgeParents.size(); ++p )
+    {
+        indexOfLabel[allEdgePlaques[2 * p]] = p;
+        edgeParents[p] = p;
+    }
+
+    for( size_t t = 0; t + 1 < allTouchingLabels.size(); t += 2 )
+    {
+        int first = findEdgeRoot(edgeParents, indexOfLabel[allTouchingLabels[t]]);
+        int second = findEdgeRoot(edgeParents, indexOfLabel[allTouchingLabels[t + 1]]);
+        if( first != second )
+        {
+            edgeParents[std::max(first, second)] = std::min(first, second);
+        }
+    }
+
+    for( size_t p = 0; p < edgeParents.size(); ++p )
+    {
+        edgeSizes[findEdgeRoot(edgeParents, p)] += allEdgePlaques[2 * p + 1];
+    }
+
+    for( size_t p = 0; p < edgeParents.size(); ++p )
+    {
+        if( edgeParents[p] == static_cast<int>(p) )
+        {
+            ++totalCounts[0];
+            ++totalCounts[1 + getSizeBin(edgeSizes[p])];
+            largestPlaqueArea = std::max(largestPlaqueArea, static_cast<int>(edgeSizes[p]));
+        }
+    }
+
+    plaqueCount = totalCounts[0];
+    std::copy(totalCounts.begin() + 1, totalCounts.end(), plaqueSizeDistribution.begin());
+}
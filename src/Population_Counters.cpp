@@ -0,0 +1,104 @@
+/* Population_Counters.cpp */
+// Implements the counters of the agents local to this process.
+
+#include "Population_Counters.h"
+#include "Epithelial_Cell_Agent.h"
+
+
+PopulationCounters* PopulationCounters::theInstance = nullptr;
+
+
+/**********************
+*   PopulationCounters::PopulationCounters - Constructor. All counts start at 0.
+**********************/
+PopulationCounters::PopulationCounters()
+{
+    reset(-1);
+}
+
+
+
+/**********************
+*   PopulationCounters::instance - Gets the counters of this process, creating them on the first call.
+**********************/
+PopulationCounters* PopulationCounters::instance()
+{
+    if( theInstance == nullptr )
+    {
+        theInstance = new PopulationCounters();
+    }
+
+    return theInstance;
+}
+
+
+
+/**********************
+*   PopulationCounters::reset - Sets all counts to 0, for a new model running on the process with the passed rank.
+**********************/
+void PopulationCounters::reset(int processRank)
+{
+    rank = processRank;
+
+    for( int state = 0; state < 3; ++state )
+    {
+        epithelialCellsCountByState[state] = 0;
+    }
+
+    for( int agentType = 0; agentType < 4; ++agentType )
+    {
+        mobileAgentsCountByType[agentType] = 0;
+    }
+}
+
+
+
+/**********************
+*   PopulationCounters::epithelialCellAdded - Counts a newly created epithelial cell, if it is local to this process.
+**********************/
+void PopulationCounters::epithelialCellAdded(int currentRank, int internalState)
+{
+    if( currentRank == rank )
+    {
+        ++epithelialCellsCountByState[internalState];
+    }
+}
+
+
+
+/**********************
+*   PopulationCounters::epithelialCellStateChanged - Moves a local epithelial cell from the count of its old internal state to the count of its new one.
+**********************/
+void PopulationCounters::epithelialCellStateChanged(int currentRank, int oldInternalState, int newInternalState)
+{
+    if( currentRank == rank )
+    {
+        --epithelialCellsCountByState[oldInternalState];
+        ++epithelialCellsCountByState[newInternalState];
+    }
+}
+
+
+
+/**********************
+*   PopulationCounters getters for the counts which combine several epithelial cell states or agent types.
+**********************/
+int PopulationCounters::getAliveEpithelialCellsCount() const
+{
+    return epithelialCellsCountByState[EpithelialCellAgent::Healthy] + epithelialCellsCountByState[EpithelialCellAgent::Infected];
+}
+
+int PopulationCounters::getInfectedEpithelialCellsCount() const
+{
+    return epithelialCellsCountByState[EpithelialCellAgent::Infected];
+}
+
+int PopulationCounters::getDeadEpithelialCellsCount() const
+{
+    return epithelialCellsCountByState[EpithelialCellAgent::Dead];
+}
+
+int PopulationCounters::getTotalAgentsCount() const
+{
+    return getAliveEpithelialCellsCount() + getDeadEpithelialCellsCount() + getVirionsCount() + getInnateImmuneCellsCount() + getSpecialisedImmuneCellsCount();
+}
@@ -0,0 +1,127 @@
+/* Process_Grid_Autotune.cpp */
+// Implements the choice of the process grid shape from short calibration runs of the model on each of the candidate shapes.
+
+#include <map>
+#include <fstream>
+#include <iostream>
+#include "repast_hpc/RepastProcess.h"
+
+#include "Process_Grid_Autotune.h"
+#include "Process_Grid_Mapping.h"
+#include "Virus_Cell_Model.h"
+
+
+/**********************
+*   ProcessGridAutotune::ProcessGridAutotune - Constructor. Keeps the arguments needed to create the calibration models.
+**********************/
+ProcessGridAutotune::ProcessGridAutotune(std::string theConfigFile, std::string thePropsFile, int theArgc, char** theArgv):
+configFile(theConfigFile),
+propsFile(thePropsFile),
+argc(theArgc),
+argv(theArgv)
+{
+}
+
+
+
+/**********************
+*   ProcessGridAutotune::findCandidateProcessGrids - Finds the process grids with the passed count of processes which split the grid evenly.
+*   Each candidate is given by its count of processes on the X axis.
+**********************/
+void ProcessGridAutotune::findCandidateProcessGrids(int processesCount, int gridDimension, std::vector<int>& candidateCountsXAxis) const
+{
+    for( int countXAxis = 1; countXAxis <= processesCount; ++countXAxis )
+    {
+        if( processesCount % countXAxis != 0 )
+        {
+            continue;
+        }
+
+        int countYAxis = processesCount / countXAxis;
+        if( gridDimension % countXAxis == 0 && gridDimension % countYAxis == 0 )
+        {
+            candidateCountsXAxis.push_back(countXAxis);
+        }
+    }
+}
+
+
+
+/**********************
+*   ProcessGridAutotune::findFastestProcessGrid - Times a few steps of the model on each candidate process grid. Each calibration run has its own
+*   Repast process, communicator and model, all of which are destroyed before the next one, so the simulation itself starts from a clean state.
+*   The step time of a candidate is the time of its slowest process, as that is what the whole simulation waits for.
+*   The calibration runs always start new simulations and write no checkpoints, so a restart or fork requested for the simulation does not touch them.
+**********************/
+void ProcessGridAutotune::findFastestProcessGrid(boost::mpi::communicator& world, int gridDimension, bool isNodeAware, int calibrationSteps,
+                                                 std::string outputDirectory, int& bestCountXAxis, int& bestCountYAxis)
+{
+    std::vector<int> candidateCountsXAxis;
+    findCandidateProcessGrids(world.size(), gridDimension, candidateCountsXAxis);
+    if( candidateCountsXAxis.empty() )
+    {
+        if( world.rank() == 0 )
+        {
+            std::cout<<"No process grid with "<<world.size()<<" processes splits the grid evenly! The process grid from the properties file is used."<<std::endl;
+        }
+        return;
+    }
+
+    std::vector<double> stepTimes;
+    std::vector<double> synchronisationTimes;
+    double bestStepTime = -1.0;
+    for( size_t c = 0; c < candidateCountsXAxis.size(); ++c )
+    {
+        int countXAxis = candidateCountsXAxis[c];
+        int countYAxis = world.size() / countXAxis;
+
+        std::map<std::string, std::string> propertyOverrides;
+        propertyOverrides["count.of.processes.X.axis"] = std::to_string(countXAxis);
+        propertyOverrides["count.of.processes.Y.axis"] = std::to_string(countYAxis);
+        propertyOverrides["record.timestep.timing"] = "false";
+        propertyOverrides["restart.from.checkpoint"] = "";
+        propertyOverrides["fork.from.checkpoint"] = "";
+        propertyOverrides["checkpoint.interval"] = "0";
+
+        boost::mpi::communicator calibrationComm(ProcessGridMapping::createModelCommunicator(world, countXAxis, countYAxis, isNodeAware, false), boost::mpi::comm_take_ownership);
+        repast::RepastProcess::init(configFile, &calibrationComm);
+
+        VirusCellModel* calibrationModel = new VirusCellModel(propsFile, argc, argv, &calibrationComm, &propertyOverrides);
+        calibrationModel->init();
+
+        double stepTime = 0.0;
+        double synchronisationTime = 0.0;
+        calibrationModel->runCalibrationSteps(calibrationSteps, stepTime, synchronisationTime);
+
+        delete calibrationModel;
+        repast::RepastProcess::instance()->done();
+
+        stepTimes.push_back(stepTime);
+        synchronisationTimes.push_back(synchronisationTime);
+        if( world.rank() == 0 )
+        {
+            std::cout<<"Process grid autotune: "<<countXAxis<<"x"<<countYAxis<<" took "<<stepTime<<" s for "<<calibrationSteps<<" steps"<<std::endl;
+        }
+
+        // The times are the maximum over the processes, so all processes make the same choice.
+        if( bestStepTime < 0 || stepTime < bestStepTime )
+        {
+            bestStepTime = stepTime;
+            bestCountXAxis = countXAxis;
+            bestCountYAxis = countYAxis;
+        }
+    }
+
+    if( world.rank() == 0 )
+    {
+        std::ofstream autotuneOutput((outputDirectory + "/process_grid_autotune.csv").c_str());
+        autotuneOutput<<"processes X axis,processes Y axis,step time (s),synchronisation time (s),chosen"<<std::endl;
+        for( size_t c = 0; c < candidateCountsXAxis.size(); ++c )
+        {
+            autotuneOutput<<candidateCountsXAxis[c]<<","<<world.size() / candidateCountsXAxis[c]<<","<<stepTimes[c]<<","<<synchronisationTimes[c]<<","
+                <<(candidateCountsXAxis[c] == bestCountXAxis ? 1 : 0)<<std::endl;
+        }
+
+        std::cout<<"Process grid autotune: chose "<<bestCountXAxis<<"x"<<bestCountYAxis<<std::endl;
+    }
+}
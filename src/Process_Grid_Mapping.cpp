@@ -0,0 +1,217 @@
+/* Process_Grid_Mapping.cpp */
+// Implements the mapping of the sections of the process grid onto the processes, keeping neighbouring sections on the same node where possible.
+
+#include <algorithm>
+#include <iostream>
+
+#include "Process_Grid_Mapping.h"
+
+
+/**********************
+*   ProcessGridMapping::ProcessGridMapping - Constructor. Finds the node each process of the communicator is on.
+**********************/
+ProcessGridMapping::ProcessGridMapping(MPI_Comm comm, int processesCountX, int processesCountY):
+processesCountXAxis(processesCountX),
+processesCountYAxis(processesCountY)
+{
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    // The processes sharing memory are on the same node. Name each node by the lowest rank on it.
+    MPI_Comm nodeComm;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+    int nodeLeader = rank;
+    MPI_Allreduce(MPI_IN_PLACE, &nodeLeader, 1, MPI_INT, MPI_MIN, nodeComm);
+    MPI_Comm_free(&nodeComm);
+
+    std::vector<int> nodeLeaderOfRank(size);
+    MPI_Allgather(&nodeLeader, 1, MPI_INT, nodeLeaderOfRank.data(), 1, MPI_INT, comm);
+
+    // Number the nodes in the order of their leaders.
+    std::vector<int> nodeLeaders(nodeLeaderOfRank);
+    std::sort(nodeLeaders.begin(), nodeLeaders.end());
+    nodeLeaders.erase(std::unique(nodeLeaders.begin(), nodeLeaders.end()), nodeLeaders.end());
+
+    nodeOfRank.resize(size);
+    processesPerNode.resize(nodeLeaders.size(), 0);
+    for( int r = 0; r < size; ++r )
+    {
+        nodeOfRank[r] = std::lower_bound(nodeLeaders.begin(), nodeLeaders.end(), nodeLeaderOfRank[r]) - nodeLeaders.begin();
+        ++processesPerNode[nodeOfRank[r]];
+    }
+}
+
+
+
+/**********************
+*   ProcessGridMapping::findNodeBlockShape - Finds the shape of the block of sections each node is to handle. All nodes need to have
+*   the same count of processes and the block needs to tile the grid. Of the possible shapes, the one with the shortest perimeter is chosen,
+*   as its perimeter is what the node exchanges with the other nodes.
+**********************/
+bool ProcessGridMapping::findNodeBlockShape(int& blockSizeX, int& blockSizeY) const
+{
+    int processesOnNode = processesPerNode[0];
+    for( size_t n = 1; n < processesPerNode.size(); ++n )
+    {
+        if( processesPerNode[n] != processesOnNode )
+        {
+            return false;
+        }
+    }
+
+    bool isShapeFound = false;
+    for( int sizeX = 1; sizeX <= processesOnNode; ++sizeX )
+    {
+        if( processesOnNode % sizeX != 0 )
+        {
+            continue;
+        }
+
+        int sizeY = processesOnNode / sizeX;
+        if( processesCountXAxis % sizeX != 0 || processesCountYAxis % sizeY != 0 )
+        {
+            continue;
+        }
+
+        if( !isShapeFound || sizeX + sizeY < blockSizeX + blockSizeY )
+        {
+            blockSizeX = sizeX;
+            blockSizeY = sizeY;
+            isShapeFound = true;
+        }
+    }
+
+    return isShapeFound;
+}
+
+
+
+/**********************
+*   ProcessGridMapping::createNodeAwareCommunicator - Creates the communicator whose rank order hands each node a block of the grid.
+*   Node n handles the n-th block (in row-major order of the blocks) and its processes handle the sections of the block in the order of their ranks.
+**********************/
+MPI_Comm ProcessGridMapping::createNodeAwareCommunicator(MPI_Comm comm, int& blockSizeX, int& blockSizeY) const
+{
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    int section = rank;
+    if( findNodeBlockShape(blockSizeX, blockSizeY) )
+    {
+        // The index of the process among the processes on its node.
+        int indexOnNode = 0;
+        for( int r = 0; r < rank; ++r )
+        {
+            if( nodeOfRank[r] == nodeOfRank[rank] )
+            {
+                ++indexOnNode;
+            }
+        }
+
+        int blocksCountYAxis = processesCountYAxis / blockSizeY;
+        int blockX = nodeOfRank[rank] / blocksCountYAxis;
+        int blockY = nodeOfRank[rank] % blocksCountYAxis;
+        int sectionX = blockX * blockSizeX + indexOnNode / blockSizeY;
+        int sectionY = blockY * blockSizeY + indexOnNode % blockSizeY;
+        section = sectionX * processesCountYAxis + sectionY;
+    }
+    else
+    {
+        blockSizeX = 0;
+        blockSizeY = 0;
+    }
+
+    MPI_Comm mappedComm;
+    MPI_Comm_split(comm, 0, section, &mappedComm);
+    return mappedComm;
+}
+
+
+
+/**********************
+*   ProcessGridMapping::countInterNodeEdges - Counts the neighbouring pairs of sections handled on different nodes. Each pair is counted once,
+*   even if the two sections neighbour each other in several directions (which happens on grids with less than 3 processes on an axis).
+**********************/
+int ProcessGridMapping::countInterNodeEdges(const std::vector<int>& nodeOfSection) const
+{
+    int interNodeEdges = 0;
+    for( int x = 0; x < processesCountXAxis; ++x )
+    {
+        for( int y = 0; y < processesCountYAxis; ++y )
+        {
+            int section = x * processesCountYAxis + y;
+
+            std::vector<int> neighbourSections;
+            for( int dx = -1; dx <= 1; ++dx )
+            {
+                for( int dy = -1; dy <= 1; ++dy )
+                {
+                    int neighbourX = (x + dx + processesCountXAxis) % processesCountXAxis;
+                    int neighbourY = (y + dy + processesCountYAxis) % processesCountYAxis;
+                    int neighbourSection = neighbourX * processesCountYAxis + neighbourY;
+
+                    // Count each pair from its lower section only.
+                    if( neighbourSection > section && std::find(neighbourSections.begin(), neighbourSections.end(), neighbourSection) == neighbourSections.end() )
+                    {
+                        neighbourSections.push_back(neighbourSection);
+                        if( nodeOfSection[neighbourSection] != nodeOfSection[section] )
+                        {
+                            ++interNodeEdges;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return interNodeEdges;
+}
+
+
+
+/**********************
+*   ProcessGridMapping::createModelCommunicator - Creates the communicator the model is to run on. Without the node-aware mapping it is a duplicate
+*   of the passed communicator, so the sections are handed out in rank order.
+**********************/
+MPI_Comm ProcessGridMapping::createModelCommunicator(MPI_Comm comm, int processesCountXAxis, int processesCountYAxis, bool isNodeAware, bool isMappingLogged)
+{
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    MPI_Comm modelComm;
+    if( size != processesCountXAxis * processesCountYAxis )
+    {
+        MPI_Comm_dup(comm, &modelComm);
+        return modelComm;
+    }
+
+    ProcessGridMapping gridMapping(comm, processesCountXAxis, processesCountYAxis);
+    std::vector<int> nodeOfSection = gridMapping.getNodeOfRank();
+
+    int blockSizeX = 0;
+    int blockSizeY = 0;
+    if( isNodeAware )
+    {
+        modelComm = gridMapping.createNodeAwareCommunicator(comm, blockSizeX, blockSizeY);
+
+        int node = gridMapping.getNodeOfRank()[rank];
+        MPI_Allgather(&node, 1, MPI_INT, nodeOfSection.data(), 1, MPI_INT, modelComm);
+    }
+    else
+    {
+        MPI_Comm_dup(comm, &modelComm);
+    }
+
+    int modelRank;
+    MPI_Comm_rank(modelComm, &modelRank);
+    if( isMappingLogged && modelRank == 0 )
+    {
+        std::cout<<"Process grid mapping: node blocks of "<<blockSizeX<<"x"<<blockSizeY<<" sections (0x0 is rank order), "
+            <<gridMapping.countInterNodeEdges(nodeOfSection)<<" inter-node neighbour pairs ("
+            <<gridMapping.countInterNodeEdges(gridMapping.getNodeOfRank())<<" in rank order)"<<std::endl;
+    }
+
+    return modelComm;
+}
@@ -0,0 +1,271 @@
+/* Process_Neighbourhood.cpp */
+// Implements the communication layer connecting each process only to its neighbours in the wraparound process grid.
+
+#include <algorithm>
+#include <iostream>
+
+#include "Process_Neighbourhood.h"
+
+
+/**********************
+*   ProcessNeighbourhood::ProcessNeighbourhood - Constructor. Builds the periodic Cartesian topology of the process grid, finds the
+*   Moore neighbours of this process in it and creates the distributed graph communicator connecting the process to them.
+**********************/
+ProcessNeighbourhood::ProcessNeighbourhood(boost::mpi::communicator* comm, int processesCountXAxis, int processesCountYAxis):
+isSharedMemoryEnabled(false),
+nodeComm(MPI_COMM_NULL),
+sharedWindow(MPI_WIN_NULL),
+mailboxBytes(0),
+sharedExchangeCount(0),
+ownSegment(nullptr),
+remoteNeighbourhoodComm(MPI_COMM_NULL),
+exchangeRequest(MPI_REQUEST_NULL),
+isExchangeInFlight(false),
+blockBytes(0)
+{
+    processDims[0] = processesCountXAxis;
+    processDims[1] = processesCountYAxis;
+
+    // The grid wraps around on both axes. The ranks are not reordered, as they need to match the ranks used by the grid projection.
+    int periods[2] = { 1, 1 };
+    MPI_Cart_create(*comm, 2, processDims, periods, 0, &cartesianComm);
+
+    int rank;
+    MPI_Comm_rank(cartesianComm, &rank);
+    MPI_Cart_coords(cartesianComm, rank, 2, processCoords);
+
+    findNeighbourRanks(processCoords, neighbourRanks, neighbourIndexInDirection);
+
+    // The neighbourhood is symmetric, so the same ranks are both the sources and the destinations of the graph.
+    int neighbourCount = neighbourRanks.size();
+    MPI_Dist_graph_create_adjacent(cartesianComm, neighbourCount, neighbourRanks.data(), MPI_UNWEIGHTED,
+                                   neighbourCount, neighbourRanks.data(), MPI_UNWEIGHTED, MPI_INFO_NULL, 0, &neighbourhoodComm);
+
+    sendByteCounts.resize(neighbourCount, 0);
+    sendByteDispls.resize(neighbourCount, 0);
+    recvByteCounts.resize(neighbourCount, 0);
+    recvByteDispls.resize(neighbourCount, 0);
+    neighbourSegments.resize(neighbourCount, nullptr);
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::findNeighbourRanks - Finds the ranks of the (at most 8) processes surrounding the process at the passed coordinates,
+*   and the index of the neighbour in each direction. The periodic topology wraps the out of range coordinates around.
+**********************/
+void ProcessNeighbourhood::findNeighbourRanks(const int* coords, std::vector<int>& ranks, int directionIndices[3][3]) const
+{
+    int rank;
+    MPI_Cart_rank(cartesianComm, const_cast<int*>(coords), &rank);
+
+    ranks.clear();
+    for( int dx = -1; dx <= 1; ++dx )
+    {
+        for( int dy = -1; dy <= 1; ++dy )
+        {
+            directionIndices[dx + 1][dy + 1] = -1;
+            if( dx == 0 && dy == 0 )
+            {
+                continue;
+            }
+
+            int neighbourCoords[2] = { coords[0] + dx, coords[1] + dy };
+            int neighbourRank;
+            MPI_Cart_rank(cartesianComm, neighbourCoords, &neighbourRank);
+
+            // On small grids the same process can neighbour this one from several directions, or this process can neighbour itself.
+            // Keep every neighbour only once, as all data sent to a process goes in a single message.
+            if( neighbourRank == rank )
+            {
+                continue;
+            }
+
+            std::vector<int>::iterator existingNeighbour = std::find(ranks.begin(), ranks.end(), neighbourRank);
+            directionIndices[dx + 1][dy + 1] = existingNeighbour - ranks.begin();
+            if( existingNeighbour == ranks.end() )
+            {
+                ranks.push_back(neighbourRank);
+            }
+        }
+    }
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::enableSharedMemoryExchange - Sets up the shared memory path of the blocking exchange. Finds which neighbours are on
+*   the same node, allocates this process's mailboxes in a window shared by the processes of the node, and builds the graph communicator 
+*   connecting the process to the neighbours on other nodes only.
+**********************/
+void ProcessNeighbourhood::enableSharedMemoryExchange(int maxBytesPerNeighbour)
+{
+    if( isSharedMemoryEnabled )
+    {
+        return;
+    }
+
+    int neighbourCount = neighbourRanks.size();
+    MPI_Comm_split_type(cartesianComm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+
+    // Find the rank of each neighbour on the node communicator, if it is on this node.
+    MPI_Group cartesianGroup, nodeGroup;
+    MPI_Comm_group(cartesianComm, &cartesianGroup);
+    MPI_Comm_group(nodeComm, &nodeGroup);
+    std::vector<int> neighbourNodeRanks(neighbourCount, MPI_UNDEFINED);
+    MPI_Group_translate_ranks(cartesianGroup, neighbourCount, neighbourRanks.data(), nodeGroup, neighbourNodeRanks.data());
+    MPI_Group_free(&cartesianGroup);
+    MPI_Group_free(&nodeGroup);
+
+    // Allocate the mailboxes, keeping every mailbox aligned for the records in it.
+    mailboxBytes = ((2 * sizeof(int) + maxBytesPerNeighbour + 7) / 8) * 8;
+    MPI_Aint segmentBytes = (MPI_Aint)2 * neighbourCount * mailboxBytes;
+    MPI_Win_allocate_shared(segmentBytes, 1, MPI_INFO_NULL, nodeComm, &ownSegment, &sharedWindow);
+    if( segmentBytes > 0 )
+    {
+        std::memset(ownSegment, 0, segmentBytes);
+    }
+
+    // The window stays open for the whole run. The processes synchronise through the exchange numbers in the mailboxes only.
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, sharedWindow);
+    MPI_Win_sync(sharedWindow);
+    MPI_Barrier(nodeComm);
+    MPI_Win_sync(sharedWindow);
+
+    remoteNeighbourIndices.clear();
+    indexInNeighbourList.resize(neighbourCount, -1);
+    for( int i = 0; i < neighbourCount; ++i )
+    {
+        if( neighbourNodeRanks[i] == MPI_UNDEFINED )
+        {
+            remoteNeighbourIndices.push_back(i);
+            continue;
+        }
+
+        MPI_Aint neighbourSegmentBytes;
+        int displacementUnit;
+        MPI_Win_shared_query(sharedWindow, neighbourNodeRanks[i], &neighbourSegmentBytes, &displacementUnit, &neighbourSegments[i]);
+
+        // The neighbours of the neighbour are found in the same order as it finds them itself, so this gives the mailbox it keeps for this process.
+        int neighbourCoords[2];
+        std::vector<int> ranksAroundNeighbour;
+        int directionIndices[3][3];
+        getProcessCoordinatesOfRank(neighbourRanks[i], neighbourCoords);
+        findNeighbourRanks(neighbourCoords, ranksAroundNeighbour, directionIndices);
+
+        int rank;
+        MPI_Comm_rank(cartesianComm, &rank);
+        indexInNeighbourList[i] = std::find(ranksAroundNeighbour.begin(), ranksAroundNeighbour.end(), rank) - ranksAroundNeighbour.begin();
+    }
+
+    std::vector<int> remoteNeighbourRanks;
+    for( size_t r = 0; r < remoteNeighbourIndices.size(); ++r )
+    {
+        remoteNeighbourRanks.push_back(neighbourRanks[remoteNeighbourIndices[r]]);
+    }
+
+    int remoteNeighbourCount = remoteNeighbourRanks.size();
+    MPI_Dist_graph_create_adjacent(cartesianComm, remoteNeighbourCount, remoteNeighbourRanks.data(), MPI_UNWEIGHTED,
+                                   remoteNeighbourCount, remoteNeighbourRanks.data(), MPI_UNWEIGHTED, MPI_INFO_NULL, 0, &remoteNeighbourhoodComm);
+
+    isSharedMemoryEnabled = true;
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::~ProcessNeighbourhood - Destructor. Frees the communicators and the shared memory window created by the class.
+**********************/
+ProcessNeighbourhood::~ProcessNeighbourhood()
+{
+    if( isExchangeInFlight )
+    {
+        MPI_Wait(&exchangeRequest, MPI_STATUS_IGNORE);
+    }
+
+    if( isSharedMemoryEnabled )
+    {
+        MPI_Win_unlock_all(sharedWindow);
+        MPI_Win_free(&sharedWindow);
+        MPI_Comm_free(&remoteNeighbourhoodComm);
+        MPI_Comm_free(&nodeComm);
+    }
+
+    MPI_Comm_free(&neighbourhoodComm);
+    MPI_Comm_free(&cartesianComm);
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::getNeighbourIndex - Returns the index of the passed rank in the list of neighbours or -1 if it is not a neighbour.
+**********************/
+int ProcessNeighbourhood::getNeighbourIndex(int rank) const
+{
+    std::vector<int>::const_iterator iter = std::find(neighbourRanks.begin(), neighbourRanks.end(), rank);
+    if( iter == neighbourRanks.end() )
+    {
+        return -1;
+    }
+
+    return iter - neighbourRanks.begin();
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::getProcessCoordinatesOfRank - Gets the coordinates of the passed rank in the process grid.
+**********************/
+void ProcessNeighbourhood::getProcessCoordinatesOfRank(int rank, int* coords) const
+{
+    MPI_Cart_coords(cartesianComm, rank, 2, coords);
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::testExchange - Returns whether the posted non-blocking exchange has completed. Does not wait for it.
+**********************/
+bool ProcessNeighbourhood::testExchange()
+{
+    if( !isExchangeInFlight )
+    {
+        return true;
+    }
+
+    int isComplete = 0;
+    MPI_Test(&exchangeRequest, &isComplete, MPI_STATUS_IGNORE);
+    if( isComplete )
+    {
+        // The request has been freed by MPI_Test, so completeExchange should not wait on it again.
+        exchangeRequest = MPI_REQUEST_NULL;
+    }
+
+    return isComplete != 0;
+}
+
+
+
+/**********************
+*   ProcessNeighbourhood::exchangeBytes - Exchanges the packed send buffer with the neighbours connected by the passed graph communicator. 
+*   The byte counts go first, so that each process can size its receive buffer, then the data itself in one sparse all-to-all.
+**********************/
+void ProcessNeighbourhood::exchangeBytes(MPI_Comm comm, int commNeighbourCount)
+{
+    MPI_Neighbor_alltoall(sendByteCounts.data(), 1, MPI_INT, recvByteCounts.data(), 1, MPI_INT, comm);
+
+    int totalRecvBytes = 0;
+    for( int i = 0; i < commNeighbourCount; ++i )
+    {
+        recvByteDispls[i] = totalRecvBytes;
+        totalRecvBytes += recvByteCounts[i];
+    }
+
+    if( recvBuffer.size() < (size_t)totalRecvBytes )
+    {
+        recvBuffer.resize(totalRecvBytes);
+    }
+
+    MPI_Neighbor_alltoallv(sendBuffer.data(), sendByteCounts.data(), sendByteDispls.data(), MPI_BYTE,
+                           recvBuffer.data(), recvByteCounts.data(), recvByteDispls.data(), MPI_BYTE, comm);
+}
@@ -0,0 +1,222 @@
+/* Raster_Pyramid.cpp */
+// Implements the in-situ block summaries of the grid and their multi-level pyramid frames.
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Raster_Pyramid.h"
+
+
+static const int32_t rasterVersion = 1;
+static const unsigned int rasterDensityScale = 64;
+
+
+/**********************
+*   appendInt32 - Appends the value to the frame, in native byte order.
+**********************/
+static void appendInt32(std::string& frame, int32_t value)
+{
+    frame.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+
+
+/**********************
+*   greatestCommonDivisor - Finds the greatest common divisor of the two passed positive numbers.
+**********************/
+static int greatestCommonDivisor(int a, int b)
+{
+    while( b != 0 )
+    {
+        int remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+
+    return a;
+}
+
+
+
+/**********************
+*   RasterPyramid::RasterPyramid - Constructor. Finds the largest block size up to the requested one which tiles the grid and every section,
+*   so each block lies within a single process's section.
+**********************/
+RasterPyramid::RasterPyramid(boost::mpi::communicator* comm, int gridSizeX, int gridSizeY, int theLocalStartX, int theLocalStartY, int localSizeX, int localSizeY,
+                             int requestedBlockSize, std::string fileName):
+localStartX(theLocalStartX),
+localStartY(theLocalStartY),
+outputFileName(fileName)
+{
+    MPI_Comm_dup(*comm, &rasterComm);
+    MPI_Comm_rank(rasterComm, &rank);
+
+    blockSize = std::max(1, requestedBlockSize);
+    while( gridSizeX % blockSize != 0 || gridSizeY % blockSize != 0 || greatestCommonDivisor(localSizeX, localSizeY) % blockSize != 0
+           || localStartX % blockSize != 0 || localStartY % blockSize != 0 )
+    {
+        --blockSize;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &blockSize, 1, MPI_INT, MPI_MIN, rasterComm);
+
+    // The sections tile the grid, so the smallest block size found by any process also tiles every other section.
+    while( gridSizeX % blockSize != 0 || gridSizeY % blockSize != 0 || localSizeX % blockSize != 0 || localSizeY % blockSize != 0 )
+    {
+        --blockSize;
+    }
+
+    blocksCountX = gridSizeX / blockSize;
+    blocksCountY = gridSizeY / blockSize;
+    localBlockSums.resize(ChannelsCount * blocksCountX * blocksCountY, 0);
+    if( rank == 0 )
+    {
+        gridBlockSums.resize(localBlockSums.size(), 0);
+    }
+}
+
+
+
+/**********************
+*   RasterPyramid::~RasterPyramid - Destructor. Frees the communicator.
+**********************/
+RasterPyramid::~RasterPyramid()
+{
+    MPI_Comm_free(&rasterComm);
+}
+
+
+
+/**********************
+*   RasterPyramid::clear - Sets all sums of this process to 0.
+**********************/
+void RasterPyramid::clear()
+{
+    std::fill(localBlockSums.begin(), localBlockSums.end(), 0);
+}
+
+
+
+/**********************
+*   RasterPyramid::restart - Closes the file of the frames written so far. The passed file is created, with its header, at the next write.
+**********************/
+void RasterPyramid::restart(std::string fileName)
+{
+    output.close();
+    output.clear();
+    outputFileName = fileName;
+}
+
+
+
+/**********************
+*   RasterPyramid::writeFrame - Adds up the block sums of all processes onto rank 0, which builds the levels of the pyramid and appends the frame.
+*   Each level halves the blocks of the one below on both axes. The count of sites in each block is carried along, so the blocks on
+*   the edge of an odd sized level are still averaged correctly.
+**********************/
+void RasterPyramid::writeFrame(int tick)
+{
+    MPI_Reduce(localBlockSums.data(), gridBlockSums.data(), localBlockSums.size(), MPI_UNSIGNED, MPI_SUM, 0, rasterComm);
+    if( rank != 0 )
+    {
+        return;
+    }
+
+    if( !output.is_open() )
+    {
+        std::string header("VCRP");
+        appendInt32(header, rasterVersion);
+        appendInt32(header, blocksCountX * blockSize);
+        appendInt32(header, blocksCountY * blockSize);
+        appendInt32(header, blockSize);
+        appendInt32(header, ChannelsCount);
+        appendInt32(header, rasterDensityScale);
+
+        output.open(outputFileName.c_str(), std::ios::binary | std::ios::trunc);
+        output.write(header.data(), header.size());
+    }
+
+    int levelSizeX = blocksCountX;
+    int levelSizeY = blocksCountY;
+    std::vector<unsigned int> levelSums(gridBlockSums);
+    std::vector<unsigned int> levelSites(levelSizeX * levelSizeY, blockSize * blockSize);
+
+    std::string levelsData;
+    int levelsCount = 0;
+    while( true )
+    {
+        appendLevel(levelsData, levelSums, levelSites, levelSizeX, levelSizeY);
+        ++levelsCount;
+        if( levelSizeX == 1 && levelSizeY == 1 )
+        {
+            break;
+        }
+
+        int coarserSizeX = (levelSizeX + 1) / 2;
+        int coarserSizeY = (levelSizeY + 1) / 2;
+        std::vector<unsigned int> coarserSums(ChannelsCount * coarserSizeX * coarserSizeY, 0);
+        std::vector<unsigned int> coarserSites(coarserSizeX * coarserSizeY, 0);
+        for( int x = 0; x < levelSizeX; ++x )
+        {
+            for( int y = 0; y < levelSizeY; ++y )
+            {
+                coarserSites[(x / 2) * coarserSizeY + y / 2] += levelSites[x * levelSizeY + y];
+                for( int c = 0; c < ChannelsCount; ++c )
+                {
+                    coarserSums[(c * coarserSizeX + x / 2) * coarserSizeY + y / 2] += levelSums[(c * levelSizeX + x) * levelSizeY + y];
+                }
+            }
+        }
+
+        levelSums.swap(coarserSums);
+        levelSites.swap(coarserSites);
+        levelSizeX = coarserSizeX;
+        levelSizeY = coarserSizeY;
+    }
+
+    std::string frame;
+    appendInt32(frame, tick);
+    appendInt32(frame, levelsCount);
+    frame += levelsData;
+    output.write(frame.data(), frame.size());
+}
+
+
+
+/**********************
+*   RasterPyramid::appendLevel - Appends a level of the pyramid to the frame: its size, then each channel quantised to a byte per block
+*   and run-length encoded, as most of the grid is uniform (all healthy, or all dead) for most of the simulation.
+**********************/
+void RasterPyramid::appendLevel(std::string& frame, const std::vector<unsigned int>& levelSums, const std::vector<unsigned int>& levelSites, int levelSizeX, int levelSizeY)
+{
+    appendInt32(frame, levelSizeX);
+    appendInt32(frame, levelSizeY);
+
+    int blocksCount = levelSizeX * levelSizeY;
+    for( int c = 0; c < ChannelsCount; ++c )
+    {
+        unsigned int scale = (c == InfectedCellsChannel || c == DeadCellsChannel) ? 255 : rasterDensityScale;
+
+        std::string encodedChannel;
+        int runLength = 0;
+        unsigned char runValue = 0;
+        for( int b = 0; b < blocksCount; ++b )
+        {
+            unsigned long long scaledSum = static_cast<unsigned long long>(levelSums[c * blocksCount + b]) * scale;
+            unsigned char value = static_cast<unsigned char>(std::min<unsigned long long>(255, (scaledSum + levelSites[b] / 2) / levelSites[b]));
+
+            if( runLength > 0 && (value != runValue || runLength == 255) )
+            {
+                encodedChannel.push_back(static_cast<char>(runLength));
+                encodedChannel.push_back(static_cast<char>(runValue));
+                runLength = 0;
+            }
+            runValue = value;
+            ++runLength;
+        }
+        encodedChannel.push_back(static_cast<char>(runLength));
+        encodedChannel.push_back(static_cast<char>(runValue));
+
+        appendInt32(frame, encodedChannel.size());
+        frame += encodedChannel;
+    }
+}
@@ -0,0 +1,264 @@
+/* Simulation_Checkpoint.cpp */
+// Implements the writing and reading of the checkpoints of the simulation through MPI-IO.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+#include "Simulation_Checkpoint.h"
+
+
+static const int checkpointHeaderBytes = 64;
+static const int32_t checkpointVersion = 2;
+static const int32_t checkpointMagic = 'V' | ('C' << 8) | ('C' << 16) | ('P' << 24);
+
+
+/**********************
+*   SimulationCheckpoint::SimulationCheckpoint - Constructor. Gathers the sections of all processes, so the owner of any site can be looked up
+*   when the agents are handed out on restart.
+**********************/
+SimulationCheckpoint::SimulationCheckpoint(boost::mpi::communicator* comm, int theGridSizeX, int theGridSizeY, int localStartX, int localStartY,
+                                           int localSizeX, int localSizeY):
+gridSizeX(theGridSizeX),
+gridSizeY(theGridSizeY)
+{
+    MPI_Comm_dup(*comm, &checkpointComm);
+    MPI_Comm_rank(checkpointComm, &rank);
+    MPI_Comm_size(checkpointComm, &processesCount);
+
+    int localSection[4] = { localStartX, localStartY, localSizeX, localSizeY };
+    std::vector<int> sections(4 * processesCount);
+    MPI_Allgather(localSection, 4, MPI_INT, sections.data(), 4, MPI_INT, checkpointComm);
+
+    // The sections form a grid, so each is identified by the index of its start among the distinct starts on each axis.
+    std::map<int, int> sectionIndexOfStartX;
+    std::map<int, int> sectionIndexOfStartY;
+    for( int r = 0; r < processesCount; ++r )
+    {
+        sectionIndexOfStartX[sections[4 * r]] = 0;
+        sectionIndexOfStartY[sections[4 * r + 1]] = 0;
+    }
+
+    int sectionIndex = 0;
+    std::map<int, int>::iterator startIter;
+    for( startIter = sectionIndexOfStartX.begin(); startIter != sectionIndexOfStartX.end(); ++startIter )
+    {
+        startIter->second = sectionIndex++;
+    }
+    sectionIndex = 0;
+    for( startIter = sectionIndexOfStartY.begin(); startIter != sectionIndexOfStartY.end(); ++startIter )
+    {
+        startIter->second = sectionIndex++;
+    }
+    sectionsCountY = sectionIndexOfStartY.size();
+
+    sectionIndexOfX.resize(gridSizeX, 0);
+    sectionIndexOfY.resize(gridSizeY, 0);
+    sectionOwnerRanks.resize(sectionIndexOfStartX.size() * sectionsCountY, 0);
+    for( int r = 0; r < processesCount; ++r )
+    {
+        int indexX = sectionIndexOfStartX[sections[4 * r]];
+        int indexY = sectionIndexOfStartY[sections[4 * r + 1]];
+        for( int x = sections[4 * r]; x < sections[4 * r] + sections[4 * r + 2]; ++x )
+        {
+            sectionIndexOfX[x] = indexX;
+        }
+        for( int y = sections[4 * r + 1]; y < sections[4 * r + 1] + sections[4 * r + 3]; ++y )
+        {
+            sectionIndexOfY[y] = indexY;
+        }
+        sectionOwnerRanks[indexX * sectionsCountY + indexY] = r;
+    }
+}
+
+
+
+/**********************
+*   SimulationCheckpoint::~SimulationCheckpoint - Destructor. Frees the communicator.
+**********************/
+SimulationCheckpoint::~SimulationCheckpoint()
+{
+    MPI_Comm_free(&checkpointComm);
+}
+
+
+
+/**********************
+*   SimulationCheckpoint::write - Writes the header and the parameters (from rank 0), the state of each process and the agent records of all processes into a
+*   temporary file, and moves it over the checkpoint file once it is complete, so a job killed while writing still leaves the previous checkpoint.
+*   Only rank 0 moves the file, so all processes are told whether it managed to.
+**********************/
+bool SimulationCheckpoint::write(std::string fileName, int tick, const std::string& parametersText, const CheckpointProcessState& processState, 
+                                 const std::vector<CheckpointAgentRecord>& agentRecords)
+{
+    long long localRecordsCount = agentRecords.size();
+    long long recordsBefore = 0;
+    long long totalRecordsCount = 0;
+    MPI_Exscan(&localRecordsCount, &recordsBefore, 1, MPI_LONG_LONG, MPI_SUM, checkpointComm);
+    MPI_Allreduce(&localRecordsCount, &totalRecordsCount, 1, MPI_LONG_LONG, MPI_SUM, checkpointComm);
+    if( rank == 0 )
+    {
+        recordsBefore = 0;
+    }
+
+    std::string partialFileName = fileName + ".partial";
+    MPI_File file;
+    int openResult = MPI_File_open(checkpointComm, const_cast<char*>(partialFileName.c_str()), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+    if( openResult != MPI_SUCCESS )
+    {
+        if( rank == 0 )
+        {
+            std::cout<<"Could not open the checkpoint file "<<partialFileName<<"!"<<std::endl;
+        }
+        return false;
+    }
+    MPI_File_set_size(file, 0);
+
+    if( rank == 0 )
+    {
+        char header[checkpointHeaderBytes] = { 0 };
+        int32_t headerValues[8] = { checkpointMagic, checkpointVersion, tick, gridSizeX, gridSizeY, processesCount,
+                                    static_cast<int32_t>(sizeof(CheckpointAgentRecord)), static_cast<int32_t>(sizeof(CheckpointProcessState)) };
+        int64_t recordsCount = totalRecordsCount;
+        int32_t parametersBytes = parametersText.size();
+        std::memcpy(header, headerValues, sizeof(headerValues));
+        std::memcpy(header + sizeof(headerValues), &recordsCount, sizeof(recordsCount));
+        std::memcpy(header + sizeof(headerValues) + sizeof(recordsCount), &parametersBytes, sizeof(parametersBytes));
+        MPI_File_write_at(file, 0, header, checkpointHeaderBytes, MPI_BYTE, MPI_STATUS_IGNORE);
+        MPI_File_write_at(file, checkpointHeaderBytes, const_cast<char*>(parametersText.data()), parametersText.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+
+    // All processes have been given the same parameters, so each knows where the parameters text ends.
+    MPI_Offset statesOffset = checkpointHeaderBytes + static_cast<MPI_Offset>(parametersText.size());
+    MPI_Offset stateOffset = statesOffset + static_cast<MPI_Offset>(rank) * sizeof(CheckpointProcessState);
+    MPI_File_write_at_all(file, stateOffset, const_cast<CheckpointProcessState*>(&processState), sizeof(CheckpointProcessState), MPI_BYTE, MPI_STATUS_IGNORE);
+
+    MPI_Offset recordsOffset = statesOffset + static_cast<MPI_Offset>(processesCount) * sizeof(CheckpointProcessState)
+                               + static_cast<MPI_Offset>(recordsBefore) * sizeof(CheckpointAgentRecord);
+    MPI_File_write_at_all(file, recordsOffset, const_cast<CheckpointAgentRecord*>(agentRecords.data()), agentRecords.size() * sizeof(CheckpointAgentRecord),
+                          MPI_BYTE, MPI_STATUS_IGNORE);
+
+    MPI_File_sync(file);
+    MPI_File_close(&file);
+
+    int isRenamed = 1;
+    if( rank == 0 && std::rename(partialFileName.c_str(), fileName.c_str()) != 0 )
+    {
+        std::cout<<"Could not replace the checkpoint file "<<fileName<<"!"<<std::endl;
+        isRenamed = 0;
+    }
+    MPI_Bcast(&isRenamed, 1, MPI_INT, 0, checkpointComm);
+
+    return isRenamed != 0;
+}
+
+
+
+/**********************
+*   SimulationCheckpoint::read - Reads the header, the parameters and this process's state, then an equal share of the agent records, and sends each record
+*   to the process owning its site in a single all-to-all.
+**********************/
+bool SimulationCheckpoint::read(std::string fileName, int& tick, std::string& parametersText, CheckpointProcessState& processState, std::vector<CheckpointAgentRecord>& agentRecords)
+{
+    agentRecords.clear();
+
+    MPI_File file;
+    int openResult = MPI_File_open(checkpointComm, const_cast<char*>(fileName.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+    if( openResult != MPI_SUCCESS )
+    {
+        if( rank == 0 )
+        {
+            std::cout<<"Could not open the checkpoint file "<<fileName<<"!"<<std::endl;
+        }
+        return false;
+    }
+
+    char header[checkpointHeaderBytes] = { 0 };
+    int32_t headerValues[8];
+    int64_t totalRecordsCount;
+    int32_t parametersBytes;
+    MPI_File_read_at_all(file, 0, header, checkpointHeaderBytes, MPI_BYTE, MPI_STATUS_IGNORE);
+    std::memcpy(headerValues, header, sizeof(headerValues));
+    std::memcpy(&totalRecordsCount, header + sizeof(headerValues), sizeof(totalRecordsCount));
+    std::memcpy(&parametersBytes, header + sizeof(headerValues) + sizeof(totalRecordsCount), sizeof(parametersBytes));
+
+    // The records are raw structs, so they can only be read by the same build of the model, on a grid of the same size.
+    if( headerValues[0] != checkpointMagic || headerValues[1] != checkpointVersion || headerValues[3] != gridSizeX || headerValues[4] != gridSizeY
+        || headerValues[6] != static_cast<int32_t>(sizeof(CheckpointAgentRecord)) || headerValues[7] != static_cast<int32_t>(sizeof(CheckpointProcessState)) )
+    {
+        if( rank == 0 )
+        {
+            std::cout<<"The checkpoint file "<<fileName<<" does not match this model and grid!"<<std::endl;
+        }
+        MPI_File_close(&file);
+        return false;
+    }
+    tick = headerValues[2];
+    int checkpointProcessesCount = headerValues[5];
+
+    parametersText.assign(parametersBytes, '\0');
+    MPI_File_read_at_all(file, checkpointHeaderBytes, &parametersText[0], parametersBytes, MPI_BYTE, MPI_STATUS_IGNORE);
+
+    // A rank which did not exist in the checkpointed run reads nothing, but still takes part in the collective read.
+    MPI_Offset statesOffset = checkpointHeaderBytes + static_cast<MPI_Offset>(parametersBytes);
+    bool hasProcessState = (rank < checkpointProcessesCount);
+    MPI_Offset stateOffset = statesOffset + static_cast<MPI_Offset>(hasProcessState ? rank : 0) * sizeof(CheckpointProcessState);
+    MPI_File_read_at_all(file, stateOffset, &processState, hasProcessState ? sizeof(CheckpointProcessState) : 0, MPI_BYTE, MPI_STATUS_IGNORE);
+    if( !hasProcessState )
+    {
+        // No agent was created by this rank before, so its ids start from the beginning. It has no engine state, which the empty text marks.
+        processState.currVirionAgentId = 0;
+        processState.currInnateImmuneCellAgentId = 0;
+        processState.currSpecialisedImmuneCellAgentId = 0;
+        processState.countVirsWhichManagedToInfectACell = 0;
+        processState.randomEngineState[0] = '\0';
+    }
+
+    // The count of executed steps decides the steps of the halo synchronisations, so all processes need to take the same one, from rank 0.
+    MPI_Bcast(&processState.executedStepsCount, 1, MPI_INT, 0, checkpointComm);
+
+    long long firstRecord = totalRecordsCount * rank / processesCount;
+    long long endRecord = totalRecordsCount * (rank + 1) / processesCount;
+    std::vector<CheckpointAgentRecord> readRecords(endRecord - firstRecord);
+    MPI_Offset recordsOffset = statesOffset + static_cast<MPI_Offset>(checkpointProcessesCount) * sizeof(CheckpointProcessState)
+                               + static_cast<MPI_Offset>(firstRecord) * sizeof(CheckpointAgentRecord);
+    MPI_File_read_at_all(file, recordsOffset, readRecords.data(), readRecords.size() * sizeof(CheckpointAgentRecord), MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_close(&file);
+
+    // Hand the records out to the processes owning their sites.
+    std::vector<std::vector<CheckpointAgentRecord> > recordsOfRank(processesCount);
+    for( size_t i = 0; i < readRecords.size(); ++i )
+    {
+        recordsOfRank[getOwnerRank(readRecords[i].x, readRecords[i].y)].push_back(readRecords[i]);
+    }
+
+    std::vector<int> sendByteCounts(processesCount), sendByteDispls(processesCount), recvByteCounts(processesCount), recvByteDispls(processesCount);
+    std::vector<char> sendBuffer(readRecords.size() * sizeof(CheckpointAgentRecord));
+    int totalSendBytes = 0;
+    for( int r = 0; r < processesCount; ++r )
+    {
+        sendByteCounts[r] = recordsOfRank[r].size() * sizeof(CheckpointAgentRecord);
+        sendByteDispls[r] = totalSendBytes;
+        if( sendByteCounts[r] > 0 )
+        {
+            std::memcpy(&sendBuffer[totalSendBytes], recordsOfRank[r].data(), sendByteCounts[r]);
+        }
+        totalSendBytes += sendByteCounts[r];
+    }
+
+    MPI_Alltoall(sendByteCounts.data(), 1, MPI_INT, recvByteCounts.data(), 1, MPI_INT, checkpointComm);
+    int totalRecvBytes = 0;
+    for( int r = 0; r < processesCount; ++r )
+    {
+        recvByteDispls[r] = totalRecvBytes;
+        totalRecvBytes += recvByteCounts[r];
+    }
+
+    agentRecords.resize(totalRecvBytes / sizeof(CheckpointAgentRecord));
+    MPI_Alltoallv(sendBuffer.data(), sendByteCounts.data(), sendByteDispls.data(), MPI_BYTE,
+                  agentRecords.data(), recvByteCounts.data(), recvByteDispls.data(), MPI_BYTE, checkpointComm);
+
+    return true;
+}
@@ -0,0 +1,154 @@
+/* Spatial_Snapshot.cpp */
+// Implements the parallel writing of the spatial snapshots of the grid through MPI-IO.
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <boost/algorithm/string/trim.hpp>
+
+#include "Spatial_Snapshot.h"
+
+
+static const int snapshotHeaderBytes = 64;
+static const int snapshotVersion = 1;
+static const int snapshotLayersCount = 4;
+
+
+/**********************
+*   SpatialSnapshotWriter::SpatialSnapshotWriter - Constructor. Decides whether the epithelial cell states can be packed two per byte,
+*   which needs every section to start and end on a byte, and creates the file types selecting this process's section of each layer.
+**********************/
+SpatialSnapshotWriter::SpatialSnapshotWriter(boost::mpi::communicator* comm, int theGridSizeX, int theGridSizeY, int localStartX, int localStartY,
+                                             int theLocalSizeX, int theLocalSizeY):
+gridSizeX(theGridSizeX),
+gridSizeY(theGridSizeY),
+localSizeX(theLocalSizeX),
+localSizeY(theLocalSizeY)
+{
+    MPI_Comm_dup(*comm, &snapshotComm);
+    MPI_Comm_rank(snapshotComm, &rank);
+
+    int isPackable = (localStartY % 2 == 0 && localSizeY % 2 == 0 && gridSizeY % 2 == 0) ? 1 : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &isPackable, 1, MPI_INT, MPI_LAND, snapshotComm);
+    cellsPerStateByte = isPackable ? 2 : 1;
+
+    int stateGridSizes[2] = { gridSizeX, gridSizeY / cellsPerStateByte };
+    int stateLocalSizes[2] = { localSizeX, localSizeY / cellsPerStateByte };
+    int stateLocalStarts[2] = { localStartX, localStartY / cellsPerStateByte };
+    MPI_Type_create_subarray(2, stateGridSizes, stateLocalSizes, stateLocalStarts, MPI_ORDER_C, MPI_BYTE, &stateSectionType);
+    MPI_Type_commit(&stateSectionType);
+
+    int countGridSizes[2] = { gridSizeX, gridSizeY };
+    int countLocalSizes[2] = { localSizeX, localSizeY };
+    int countLocalStarts[2] = { localStartX, localStartY };
+    MPI_Type_create_subarray(2, countGridSizes, countLocalSizes, countLocalStarts, MPI_ORDER_C, MPI_BYTE, &countSectionType);
+    MPI_Type_commit(&countSectionType);
+}
+
+
+
+/**********************
+*   SpatialSnapshotWriter::~SpatialSnapshotWriter - Destructor. Frees the file types and the communicator.
+**********************/
+SpatialSnapshotWriter::~SpatialSnapshotWriter()
+{
+    MPI_Type_free(&stateSectionType);
+    MPI_Type_free(&countSectionType);
+    MPI_Comm_free(&snapshotComm);
+}
+
+
+
+/**********************
+*   SpatialSnapshotWriter::write - Writes the header (from rank 0) and the four layers (collectively) of a snapshot into a new file.
+**********************/
+void SpatialSnapshotWriter::write(std::string fileName, int tick, const std::vector<unsigned char>& epithelialCellStates, const std::vector<unsigned char>& virionCounts,
+                                  const std::vector<unsigned char>& innateImmuneCellCounts, const std::vector<unsigned char>& specialisedImmuneCellCounts)
+{
+    MPI_File file;
+    int openResult = MPI_File_open(snapshotComm, const_cast<char*>(fileName.c_str()), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+    if( openResult != MPI_SUCCESS )
+    {
+        if( rank == 0 )
+        {
+            std::cout<<"Could not open the snapshot file "<<fileName<<"!"<<std::endl;
+        }
+        return;
+    }
+
+    // Drop whatever an earlier run left in the file, as the new snapshot may be smaller.
+    MPI_File_set_size(file, 0);
+
+    if( rank == 0 )
+    {
+        int32_t header[snapshotHeaderBytes / sizeof(int32_t)] = { 0 };
+        header[0] = 'V' | ('C' << 8) | ('S' << 16) | ('S' << 24);
+        header[1] = snapshotVersion;
+        header[2] = tick;
+        header[3] = gridSizeX;
+        header[4] = gridSizeY;
+        header[5] = cellsPerStateByte;
+        header[6] = snapshotLayersCount;
+        MPI_File_write_at(file, 0, header, snapshotHeaderBytes, MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+
+    // Pack the epithelial cell states of neighbouring sites on the Y axis together, if every section allows it.
+    std::vector<unsigned char> packedStates(epithelialCellStates);
+    if( cellsPerStateByte == 2 )
+    {
+        packedStates.resize(epithelialCellStates.size() / 2);
+        for( size_t i = 0; i < packedStates.size(); ++i )
+        {
+            packedStates[i] = (epithelialCellStates[2 * i] & 0x0F) | ((epithelialCellStates[2 * i + 1] & 0x0F) << 4);
+        }
+    }
+
+    MPI_Offset stateLayerBytes = static_cast<MPI_Offset>(gridSizeX) * (gridSizeY / cellsPerStateByte);
+    MPI_Offset countLayerBytes = static_cast<MPI_Offset>(gridSizeX) * gridSizeY;
+    MPI_Offset layerOffset = snapshotHeaderBytes;
+
+    writeLayer(file, layerOffset, stateSectionType, packedStates);
+    layerOffset += stateLayerBytes;
+    writeLayer(file, layerOffset, countSectionType, virionCounts);
+    layerOffset += countLayerBytes;
+    writeLayer(file, layerOffset, countSectionType, innateImmuneCellCounts);
+    layerOffset += countLayerBytes;
+    writeLayer(file, layerOffset, countSectionType, specialisedImmuneCellCounts);
+
+    MPI_File_close(&file);
+}
+
+
+
+/**********************
+*   SpatialSnapshotWriter::writeLayer - Writes this process's section of a layer starting at the passed offset of the file, collectively with
+*   the other processes, so the MPI-IO layer can merge the sections into large contiguous writes.
+**********************/
+void SpatialSnapshotWriter::writeLayer(MPI_File file, MPI_Offset layerOffset, MPI_Datatype sectionType, const std::vector<unsigned char>& layer)
+{
+    MPI_File_set_view(file, layerOffset, MPI_BYTE, sectionType, const_cast<char*>("native"), MPI_INFO_NULL);
+    MPI_File_write_all(file, const_cast<unsigned char*>(layer.data()), layer.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+}
+
+
+
+/**********************
+*   SpatialSnapshotWriter::parseTicks - Parses a comma separated list of ticks, e.g. "120,240". Anything which is not a tick is ignored.
+**********************/
+std::set<int> SpatialSnapshotWriter::parseTicks(const std::string& ticksList)
+{
+    std::set<int> ticks;
+
+    std::stringstream listStream(ticksList);
+    std::string tick;
+    while( std::getline(listStream, tick, ',') )
+    {
+        boost::algorithm::trim(tick);
+        if( !tick.empty() && tick.find_first_not_of("0123456789") == std::string::npos )
+        {
+            ticks.insert(std::stoi(tick));
+        }
+    }
+
+    return ticks;
+}
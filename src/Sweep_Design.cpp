@@ -0,0 +1,264 @@
+/* Sweep_Design.cpp */
+// Implements the space-filling designs of the parameter sweeps.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "Sweep_Design.h"
+
+
+static const int sobolBits = 32;
+
+// The primitive polynomials of the Sobol sequence after its first dimension, each with the bits of its coefficients (leading and trailing ones included),
+// and the initial direction numbers of each, from the new-joe-kuo-6.21201 table.
+static const uint32_t sobolPolynomials[SweepDesign::maxSobolParameters - 1] = { 3, 7, 11, 13, 19, 25, 37, 41, 47, 55, 59, 61, 67, 91, 97, 103, 109, 115, 131 };
+static const uint32_t sobolInitialDirections[SweepDesign::maxSobolParameters - 1][7] = {
+    { 1 }, { 1, 3 }, { 1, 3, 1 }, { 1, 1, 1 }, { 1, 1, 3, 3 }, { 1, 3, 5, 13 }, { 1, 1, 5, 5, 17 }, { 1, 1, 5, 5, 5 }, { 1, 1, 7, 11, 19 },
+    { 1, 1, 5, 1, 1 }, { 1, 1, 1, 3, 11 }, { 1, 3, 5, 5, 31 }, { 1, 3, 3, 9, 7, 49 }, { 1, 1, 1, 15, 21, 21 }, { 1, 3, 1, 13, 27, 49 },
+    { 1, 1, 1, 15, 7, 5 }, { 1, 3, 1, 15, 13, 25 }, { 1, 1, 5, 5, 19, 61 }, { 1, 3, 7, 11, 23, 15, 103 }
+};
+
+
+/**********************
+*   SweepDesign::SweepDesign - Constructor. Generates the values of the parameters at all points of the design.
+**********************/
+SweepDesign::SweepDesign(const std::vector<SweepParameter>& theParameters, DesignType design, int thePointsCount, unsigned int seed):
+parameters(theParameters),
+pointsCount(std::max(0, thePointsCount))
+{
+    if( design == Sobol && parameters.size() > maxSobolParameters )
+    {
+        parameters.resize(maxSobolParameters);
+    }
+    pointValues.resize(pointsCount * parameters.size(), 0.0);
+
+    if( design == Sobol )
+    {
+        generateSobol();
+    }
+    else
+    {
+        generateLatinHypercube(seed);
+    }
+
+    // Scale the points of the unit hypercube onto the ranges of the parameters.
+    for( int p = 0; p < pointsCount; ++p )
+    {
+        for( size_t i = 0; i < parameters.size(); ++i )
+        {
+            double& value = pointValues[p * parameters.size() + i];
+            value = parameters[i].minValue + value * (parameters[i].maxValue - parameters[i].minValue);
+            if( parameters[i].isInteger )
+            {
+                value = std::round(value);
+            }
+        }
+    }
+}
+
+
+
+/**********************
+*   SweepDesign::generateLatinHypercube - Places one point in each stratum of each parameter, shuffling the strata of each parameter on its own.
+**********************/
+void SweepDesign::generateLatinHypercube(unsigned int seed)
+{
+    boost::mt19937 engine(seed);
+    boost::random::uniform_01<double> withinStratum;
+
+    std::vector<int> strata(pointsCount);
+    for( size_t i = 0; i < parameters.size(); ++i )
+    {
+        for( int p = 0; p < pointsCount; ++p )
+        {
+            strata[p] = p;
+        }
+        for( int p = pointsCount - 1; p > 0; --p )
+        {
+            std::swap(strata[p], strata[boost::random::uniform_int_distribution<int>(0, p)(engine)]);
+        }
+
+        for( int p = 0; p < pointsCount; ++p )
+        {
+            pointValues[p * parameters.size() + i] = (strata[p] + withinStratum(engine)) / pointsCount;
+        }
+    }
+}
+
+
+
+/**********************
+*   SweepDesign::generateSobol - Generates the first points of the Sobol sequence, starting from the origin, in Gray code order.
+*   The first dimension is the van der Corput sequence, and each further one follows the recurrence of its primitive polynomial.
+**********************/
+void SweepDesign::generateSobol()
+{
+    std::vector<uint32_t> directions(parameters.size() * sobolBits);
+    for( size_t i = 0; i < parameters.size(); ++i )
+    {
+        uint32_t* dimensionDirections = &directions[i * sobolBits];
+        if( i == 0 )
+        {
+            for( int k = 0; k < sobolBits; ++k )
+            {
+                dimensionDirections[k] = 1u << (sobolBits - 1 - k);
+            }
+            continue;
+        }
+
+        uint32_t polynomial = sobolPolynomials[i - 1];
+        int degree = 0;
+        while( (polynomial >> (degree + 1)) != 0 )
+        {
+            ++degree;
+        }
+
+        for( int k = 0; k < sobolBits; ++k )
+        {
+            if( k < degree )
+            {
+                dimensionDirections[k] = sobolInitialDirections[i - 1][k] << (sobolBits - 1 - k);
+                continue;
+            }
+
+            dimensionDirections[k] = dimensionDirections[k - degree] ^ (dimensionDirections[k - degree] >> degree);
+            for( int j = 1; j < degree; ++j )
+            {
+                if( (polynomial >> (degree - j)) & 1u )
+                {
+                    dimensionDirections[k] ^= dimensionDirections[k - j];
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> point(parameters.size(), 0);
+    for( int p = 0; p < pointsCount; ++p )
+    {
+        for( size_t i = 0; i < parameters.size(); ++i )
+        {
+            pointValues[p * parameters.size() + i] = point[i] / 4294967296.0;
+        }
+
+        // The next point differs from this one in the direction of the lowest zero bit of the index of this one.
+        int changedBit = 0;
+        while( (p >> changedBit) & 1 )
+        {
+            ++changedBit;
+        }
+        for( size_t i = 0; i < parameters.size(); ++i )
+        {
+            point[i] ^= directions[i * sobolBits + changedBit];
+        }
+    }
+}
+
+
+
+/**********************
+*   SweepDesign::createJobs - Creates a job for each replicate of each point. Each job overrides the swept parameters, and tags itself with its point
+*   and replicate through the sweep.point and sweep.replicate properties, so they are recorded with the rest of its parameters.
+**********************/
+std::vector<EnsembleJob> SweepDesign::createJobs(int replicatesCount, int baseSeed) const
+{
+    std::vector<EnsembleJob> jobs;
+    for( int p = 0; p < pointsCount; ++p )
+    {
+        for( int r = 0; r < replicatesCount; ++r )
+        {
+            EnsembleJob job;
+            job.name = "point_" + std::to_string(p) + "_replicate_" + std::to_string(r);
+            job.seed = baseSeed + jobs.size();
+            for( size_t i = 0; i < parameters.size(); ++i )
+            {
+                std::stringstream valueText;
+                valueText.precision(17);
+                valueText<<getValue(p, i);
+                job.propertyOverrides[parameters[i].name] = valueText.str();
+            }
+            job.propertyOverrides["sweep.point"] = std::to_string(p);
+            job.propertyOverrides["sweep.replicate"] = std::to_string(r);
+            jobs.push_back(job);
+        }
+    }
+
+    return jobs;
+}
+
+
+
+/**********************
+*   SweepDesign::writeDesign - Writes the design of the passed jobs, one row per job, which the outputs of each job can be joined with by its name.
+**********************/
+void SweepDesign::writeDesign(std::string fileName, const std::vector<EnsembleJob>& jobs) const
+{
+    std::ofstream designOutput(fileName.c_str());
+    designOutput<<"job,name,point,replicate,random seed";
+    for( size_t i = 0; i < parameters.size(); ++i )
+    {
+        designOutput<<","<<parameters[i].name;
+    }
+    designOutput<<std::endl;
+
+    designOutput.precision(17);
+    for( size_t j = 0; j < jobs.size(); ++j )
+    {
+        std::map<std::string, std::string>::const_iterator point = jobs[j].propertyOverrides.find("sweep.point");
+        std::map<std::string, std::string>::const_iterator replicate = jobs[j].propertyOverrides.find("sweep.replicate");
+        designOutput<<j<<","<<jobs[j].name<<","<<point->second<<","<<replicate->second<<","<<jobs[j].seed;
+        for( size_t i = 0; i < parameters.size(); ++i )
+        {
+            designOutput<<","<<jobs[j].propertyOverrides.find(parameters[i].name)->second;
+        }
+        designOutput<<std::endl;
+    }
+}
+
+
+
+/**********************
+*   SweepDesign::parseParameters - Parses a comma separated list of swept parameters, each as name:min:max, e.g. "virion.clearance.probability:0.1:0.5",
+*   or as name:min:max:int for an integer parameter, e.g. "count.of.virions:10:100:int".
+**********************/
+std::vector<SweepParameter> SweepDesign::parseParameters(const std::string& parametersList)
+{
+    std::vector<SweepParameter> parsedParameters;
+
+    std::stringstream listStream(parametersList);
+    std::string parameterText;
+    while( std::getline(listStream, parameterText, ',') )
+    {
+        boost::algorithm::trim(parameterText);
+
+        size_t firstSeparator = parameterText.find(':');
+        if( firstSeparator == std::string::npos || firstSeparator == 0 )
+        {
+            continue;
+        }
+
+        SweepParameter parameter;
+        parameter.name = parameterText.substr(0, firstSeparator);
+        std::string rangeText = parameterText.substr(firstSeparator + 1);
+        parameter.isInteger = (rangeText.size() > 4 && rangeText.compare(rangeText.size() - 4, 4, ":int") == 0);
+        if( parameter.isInteger )
+        {
+            rangeText.erase(rangeText.size() - 4);
+        }
+
+        std::stringstream rangeStream(rangeText);
+        char separator;
+        if( rangeStream >> parameter.minValue >> separator >> parameter.maxValue && separator == ':' && rangeStream.eof() )
+        {
+            parsedParameters.push_back(parameter);
+        }
+    }
+
+    return parsedParameters;
+}
@@ -0,0 +1,137 @@
+/* Termination_Criteria.cpp */
+// Implements the early termination of the simulation once its outcome is settled.
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include "repast_hpc/RepastProcess.h"
+
+#include "Termination_Criteria.h"
+
+
+/**********************
+*   TerminationCriteria::TerminationCriteria - Constructor.
+**********************/
+TerminationCriteria::TerminationCriteria(int theAliveCellsColumn, int theInfectedCellsColumn, int theVirionsColumn, const std::vector<int>& thePopulationColumns,
+                                         int theExtinctionTicks, bool theIsTissueDestructionChecked, int theSteadyStateWindow, double theSteadyStateTolerance,
+                                         std::string theOutputFileName):
+rank(repast::RepastProcess::instance()->rank()),
+outputFileName(theOutputFileName),
+aliveCellsColumn(theAliveCellsColumn),
+infectedCellsColumn(theInfectedCellsColumn),
+virionsColumn(theVirionsColumn),
+populationColumns(thePopulationColumns),
+extinctionTicks(std::max(0, theExtinctionTicks)),
+extinctRecordsCount(0),
+isTissueDestructionChecked(theIsTissueDestructionChecked),
+steadyStateWindow(std::max(0, theSteadyStateWindow)),
+steadyStateTolerance(theSteadyStateTolerance),
+terminationTick(0.0)
+{
+}
+
+
+
+/**********************
+*   TerminationCriteria::isEnabled - Checks whether any of the criteria is enabled.
+**********************/
+bool TerminationCriteria::isEnabled() const
+{
+    return extinctionTicks > 0 || isTissueDestructionChecked || steadyStateWindow > 0;
+}
+
+
+
+/**********************
+*   TerminationCriteria::check - Checks the criteria on the record of the tick. Once the simulation has been stopped, no more checks are made.
+**********************/
+void TerminationCriteria::check(double tick, const std::vector<long long>& values)
+{
+    if( hasTerminated() )
+    {
+        return;
+    }
+
+    // The infection is extinct when neither infected cells nor free virions are left to infect any more cells.
+    if( values[infectedCellsColumn] == 0 && values[virionsColumn] == 0 )
+    {
+        ++extinctRecordsCount;
+    }
+    else
+    {
+        extinctRecordsCount = 0;
+    }
+    if( extinctionTicks > 0 && extinctRecordsCount >= extinctionTicks )
+    {
+        terminate(tick, "infection extinct");
+        return;
+    }
+
+    if( isTissueDestructionChecked && values[aliveCellsColumn] == 0 )
+    {
+        terminate(tick, "tissue destroyed");
+        return;
+    }
+
+    // The window spans steadyStateWindow ticks, so it holds one more record than that. Each population needs to stay within the tolerance
+    // of its largest size in the window (or within the tolerance of 1, for the populations which have died out).
+    if( steadyStateWindow > 0 )
+    {
+        std::vector<long long> recordValues(populationColumns.size());
+        for( size_t i = 0; i < populationColumns.size(); ++i )
+        {
+            recordValues[i] = values[populationColumns[i]];
+        }
+        windowValues.push_back(recordValues);
+        if( windowValues.size() > static_cast<size_t>(steadyStateWindow) + 1 )
+        {
+            windowValues.pop_front();
+        }
+
+        if( windowValues.size() == static_cast<size_t>(steadyStateWindow) + 1 )
+        {
+            bool isSteady = true;
+            for( size_t i = 0; i < populationColumns.size() && isSteady; ++i )
+            {
+                long long minValue = windowValues.front()[i];
+                long long maxValue = windowValues.front()[i];
+                for( size_t r = 1; r < windowValues.size(); ++r )
+                {
+                    minValue = std::min(minValue, windowValues[r][i]);
+                    maxValue = std::max(maxValue, windowValues[r][i]);
+                }
+                isSteady = (maxValue - minValue <= steadyStateTolerance * std::max(1LL, std::llabs(maxValue)));
+            }
+
+            if( isSteady )
+            {
+                terminate(tick, "steady state");
+            }
+        }
+    }
+}
+
+
+
+/**********************
+*   TerminationCriteria::terminate - Stops the simulation after all events of the current tick, and records the reason on rank 0.
+*   The records are completed at most a tick after they are taken, so the stop comes at most a tick after the one which met the criterion.
+**********************/
+void TerminationCriteria::terminate(double tick, std::string reason)
+{
+    terminationReason = reason;
+    terminationTick = tick;
+
+    repast::ScheduleRunner& runner = repast::RepastProcess::instance()->getScheduleRunner();
+    runner.scheduleStop(std::floor(runner.currentTick()) + 0.5);
+
+    if( rank == 0 )
+    {
+        std::cout<<"Terminating the simulation early at tick "<<tick<<": "<<reason<<std::endl;
+
+        std::ofstream output(outputFileName.c_str());
+        output<<"tick,reason"<<std::endl;
+        output<<tick<<","<<reason<<std::endl;
+    }
+}
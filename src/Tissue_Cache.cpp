@@ -0,0 +1,163 @@
+/* Tissue_Cache.cpp */
+// Implements the cache of the initial tissue of each process.
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Tissue_Cache.h"
+
+
+static const int tissueCacheHeaderBytes = 32;
+static const char tissueCacheMagic[4] = { 'V', 'C', 'T', 'C' };
+static const uint32_t tissueCacheVersion = 1;
+
+
+/**********************
+*   getPaddedLength - Gets the length rounded up to a multiple of 8 bytes, so the records which follow are aligned.
+**********************/
+static size_t getPaddedLength(size_t length)
+{
+    return (length + 7) / 8 * 8;
+}
+
+
+
+/**********************
+*   TissueCache::TissueCache - Constructor. The file of the process is named after the key, so the tissues of different setups can be cached side by side.
+**********************/
+TissueCache::TissueCache(std::string directory, uint64_t theKey, int rank):
+key(theKey),
+fileData(nullptr),
+fileSize(0),
+cellRecords(nullptr),
+cellsCount(0)
+{
+    std::stringstream fileNameStream;
+    fileNameStream<<directory<<"/tissue_"<<std::hex<<std::setw(16)<<std::setfill('0')<<key<<std::dec<<"_rank"<<rank<<".bin";
+    fileName = fileNameStream.str();
+}
+
+
+
+/**********************
+*   TissueCache::~TissueCache - Destructor. Unmaps the file.
+**********************/
+TissueCache::~TissueCache()
+{
+    close();
+}
+
+
+
+/**********************
+*   TissueCache::close - Unmaps the file, if one is mapped.
+**********************/
+void TissueCache::close()
+{
+    if( fileData != nullptr )
+    {
+        munmap(const_cast<unsigned char*>(fileData), fileSize);
+        fileData = nullptr;
+    }
+    fileSize = 0;
+    cellRecords = nullptr;
+    cellsCount = 0;
+    randomEngineState.clear();
+}
+
+
+
+/**********************
+*   TissueCache::load - Maps the cached tissue into memory and checks its header. The records are used straight from the mapping.
+**********************/
+bool TissueCache::load(size_t expectedCellsCount)
+{
+    close();
+
+    int fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+    if( fileDescriptor < 0 )
+    {
+        return false;
+    }
+
+    struct stat fileStatus;
+    if( fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < tissueCacheHeaderBytes )
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    fileSize = fileStatus.st_size;
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    ::close(fileDescriptor);
+    if( mapping == MAP_FAILED )
+    {
+        fileSize = 0;
+        return false;
+    }
+    fileData = static_cast<const unsigned char*>(mapping);
+
+    uint32_t version;
+    uint64_t fileKey, fileCellsCount, stateLength;
+    std::memcpy(&version, fileData + 4, 4);
+    std::memcpy(&fileKey, fileData + 8, 8);
+    std::memcpy(&fileCellsCount, fileData + 16, 8);
+    std::memcpy(&stateLength, fileData + 24, 8);
+
+    size_t recordsOffset = tissueCacheHeaderBytes + getPaddedLength(stateLength);
+    if( std::memcmp(fileData, tissueCacheMagic, 4) != 0 || version != tissueCacheVersion || fileKey != key || fileCellsCount != expectedCellsCount
+        || fileSize != recordsOffset + fileCellsCount * sizeof(TissueCellRecord) )
+    {
+        close();
+        return false;
+    }
+
+    randomEngineState.assign(reinterpret_cast<const char*>(fileData + tissueCacheHeaderBytes), stateLength);
+    cellRecords = reinterpret_cast<const TissueCellRecord*>(fileData + recordsOffset);
+    cellsCount = fileCellsCount;
+    return true;
+}
+
+
+
+/**********************
+*   TissueCache::store - Writes the tissue to a partial file and renames it over the cached one, so a run stopped while writing never leaves a cut short file.
+**********************/
+bool TissueCache::store(const std::vector<TissueCellRecord>& records, const std::string& theRandomEngineState)
+{
+    std::string partialFileName = fileName + ".partial";
+    std::ofstream output(partialFileName.c_str(), std::ios::binary | std::ios::trunc);
+    if( !output )
+    {
+        return false;
+    }
+
+    uint32_t version = tissueCacheVersion;
+    uint64_t recordsCount = records.size();
+    uint64_t stateLength = theRandomEngineState.size();
+    output.write(tissueCacheMagic, 4);
+    output.write(reinterpret_cast<const char*>(&version), 4);
+    output.write(reinterpret_cast<const char*>(&key), 8);
+    output.write(reinterpret_cast<const char*>(&recordsCount), 8);
+    output.write(reinterpret_cast<const char*>(&stateLength), 8);
+
+    std::string paddedState(theRandomEngineState);
+    paddedState.resize(getPaddedLength(paddedState.size()), '\0');
+    output.write(paddedState.data(), paddedState.size());
+    output.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(TissueCellRecord));
+    output.close();
+
+    if( !output || std::rename(partialFileName.c_str(), fileName.c_str()) != 0 )
+    {
+        std::remove(partialFileName.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,233 @@
+/* Virus_Cell_API.cpp */
+// Implements the C API of the model library.
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <boost/mpi.hpp>
+#include "repast_hpc/RepastProcess.h"
+
+#include "Virus_Cell_API.h"
+#include "Virus_Cell_Model.h"
+
+
+/**********************
+* The model behind a handle of the C API, the communicator it runs on and the last tick it has run.
+**********************/
+struct VirusCellModelHandle
+{
+    boost::mpi::communicator* modelComm;
+    VirusCellModel* model;
+    int lastTick;
+};
+
+
+
+/**********************
+*   isFileReadable - Checks whether the named file exists and can be opened for reading.
+**********************/
+static bool isFileReadable(const char* fileName)
+{
+    return fileName != nullptr && std::ifstream(fileName).good();
+}
+
+
+
+/**********************
+*   virus_cell_create - Starts a Repast process on a duplicate of the passed communicator, so the model's messages cannot be mixed up with
+*   the caller's, then creates the model with the overridden properties and its initial agents, and schedules its events.
+*   The model only stops at the ticks requested by each run, unless the caller overrides stop.at, so its stop is moved out of the way.
+*   The files are checked on every process, and the model is only created if all processes can read them, as it is created collectively.
+**********************/
+VirusCellModelHandle* virus_cell_create(MPI_Comm comm, const VirusCellParameters* parameters)
+{
+    int areFilesReadable = (parameters != nullptr && isFileReadable(parameters->configFile) && isFileReadable(parameters->propsFile)) ? 1 : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &areFilesReadable, 1, MPI_INT, MPI_LAND, comm);
+    if( !areFilesReadable )
+    {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        if( rank == 0 )
+        {
+            std::cout<<"The model cannot be created, as its configuration or properties file cannot be read on all processes!"<<std::endl;
+        }
+        return nullptr;
+    }
+
+    std::map<std::string, std::string> propertyOverrides;
+    propertyOverrides["stop.at"] = std::to_string(std::numeric_limits<int>::max() / 2);
+    for( int i = 0; i < parameters->parametersCount; ++i )
+    {
+        std::stringstream valueText;
+        valueText.precision(17);
+        valueText<<parameters->parameters[i].value;
+        propertyOverrides[parameters->parameters[i].name] = valueText.str();
+    }
+    if( parameters->seed != 0 )
+    {
+        propertyOverrides["random.seed"] = std::to_string(parameters->seed);
+    }
+
+    VirusCellModelHandle* handle = new VirusCellModelHandle;
+    handle->modelComm = new boost::mpi::communicator(comm, boost::mpi::comm_duplicate);
+    handle->lastTick = 0;
+
+    repast::RepastProcess::init(parameters->configFile, handle->modelComm);
+    handle->model = new VirusCellModel(parameters->propsFile, 0, nullptr, handle->modelComm, &propertyOverrides);
+    handle->model->getAgentsData()->retainRecords();
+
+    handle->model->init();
+    handle->model->initSchedule(repast::RepastProcess::instance()->getScheduleRunner());
+
+    return handle;
+}
+
+
+
+/**********************
+*   virus_cell_run - Runs the schedule until just after the events of the last requested tick (the latest of which are at half a tick past it),
+*   so the next run starts with the timestep of the following tick. The record of the last tick is then completed and shared with all processes.
+**********************/
+int virus_cell_run(VirusCellModelHandle* model, int ticksCount)
+{
+    TerminationCriteria* terminationCriteria = model->model->getTerminationCriteria();
+    if( ticksCount < 1 || (terminationCriteria != nullptr && terminationCriteria->hasTerminated()) )
+    {
+        return model->lastTick;
+    }
+
+    repast::ScheduleRunner& runner = repast::RepastProcess::instance()->getScheduleRunner();
+    runner.scheduleStop(model->lastTick + ticksCount + 0.5);
+    runner.run();
+    model->lastTick = static_cast<int>(runner.currentTick());
+
+    model->model->getAgentsData()->shareRetainedRecords();
+
+    return model->lastTick;
+}
+
+
+
+/**********************
+*   virus_cell_get_termination_reason - Gets the reason of the early termination of the model. The criteria are checked on all processes alike,
+*   so each process has the reason.
+**********************/
+const char* virus_cell_get_termination_reason(const VirusCellModelHandle* model)
+{
+    TerminationCriteria* terminationCriteria = model->model->getTerminationCriteria();
+    return (terminationCriteria != nullptr) ? terminationCriteria->getTerminationReason().c_str() : "";
+}
+
+
+
+/**********************
+*   virus_cell_get_metrics_count - Gets the count of the recorded metrics.
+**********************/
+int virus_cell_get_metrics_count(const VirusCellModelHandle* model)
+{
+    return model->model->getAgentsData()->getColumnsCount();
+}
+
+
+
+/**********************
+*   virus_cell_get_metric_name - Gets the name of the metric, as in the header of the agents data file. The name lives as long as the model.
+**********************/
+const char* virus_cell_get_metric_name(const VirusCellModelHandle* model, int metric)
+{
+    if( metric < 0 || metric >= virus_cell_get_metrics_count(model) )
+    {
+        return nullptr;
+    }
+
+    return model->model->getAgentsData()->getColumnName(metric).c_str();
+}
+
+
+
+/**********************
+*   virus_cell_find_metric - Gets the index of the metric with the passed name, or -1 if there is no such metric.
+**********************/
+int virus_cell_find_metric(const VirusCellModelHandle* model, const char* name)
+{
+    for( int i = 0; i < virus_cell_get_metrics_count(model); ++i )
+    {
+        if( std::strcmp(model->model->getAgentsData()->getColumnName(i).c_str(), name) == 0 )
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+
+/**********************
+*   virus_cell_get_records_count - Gets the count of the records taken so far.
+**********************/
+int virus_cell_get_records_count(const VirusCellModelHandle* model)
+{
+    return model->model->getAgentsData()->getRetainedTicks().size();
+}
+
+
+
+/**********************
+*   virus_cell_copy_ticks - Copies the ticks of the records, from the first one, into the caller's array.
+**********************/
+int virus_cell_copy_ticks(const VirusCellModelHandle* model, double* ticks, int capacity)
+{
+    const std::vector<double>& retainedTicks = model->model->getAgentsData()->getRetainedTicks();
+    int copiedCount = std::max(0, std::min<int>(capacity, retainedTicks.size()));
+    std::copy(retainedTicks.begin(), retainedTicks.begin() + copiedCount, ticks);
+
+    return copiedCount;
+}
+
+
+
+/**********************
+*   virus_cell_copy_metric - Copies the values of the metric in the records, from the first one, into the caller's array. The records hold
+*   the values of all metrics of a tick together, so the values of one metric are gathered from every record.
+**********************/
+int virus_cell_copy_metric(const VirusCellModelHandle* model, int metric, long long* values, int capacity)
+{
+    int metricsCount = virus_cell_get_metrics_count(model);
+    if( metric < 0 || metric >= metricsCount )
+    {
+        return 0;
+    }
+
+    const std::vector<long long>& retainedValues = model->model->getAgentsData()->getRetainedValues();
+    int copiedCount = std::max(0, std::min(capacity, virus_cell_get_records_count(model)));
+    for( int r = 0; r < copiedCount; ++r )
+    {
+        values[r] = retainedValues[r * metricsCount + metric];
+    }
+
+    return copiedCount;
+}
+
+
+
+/**********************
+*   virus_cell_destroy - Deletes the model and ends its Repast process, then frees the communicator it ran on.
+**********************/
+void virus_cell_destroy(VirusCellModelHandle* model)
+{
+    if( model == nullptr )
+    {
+        return;
+    }
+
+    delete model->model;
+    repast::RepastProcess::instance()->done();
+    delete model->modelComm;
+    delete model;
+}
@@ -1,9 +1,18 @@
 /* Virus_Cell_Main.cpp */
 
+#include <map>
+#include <string>
+#include <vector>
 #include <boost/mpi.hpp>
 #include "repast_hpc/RepastProcess.h"
+#include "repast_hpc/Properties.h"
+#include "repast_hpc/Utilities.h"
 
 #include "Virus_Cell_Model.h"
+#include "Process_Grid_Mapping.h"
+#include "Process_Grid_Autotune.h"
+#include "Ensemble_Runner.h"
+#include "Sweep_Design.h"
 
 
 int main(int argc, char** argv){
@@ -14,9 +23,72 @@ int main(int argc, char** argv){
 	boost::mpi::environment env(argc, argv);
 	boost::mpi::communicator world;
 
-	repast::RepastProcess::init(configFile);
+	repast::Properties mappingProps(propsFile, argc, argv, &world);
+	int processesCountXAxis = repast::strToInt(mappingProps.getProperty("count.of.processes.X.axis"));
+	int processesCountYAxis = repast::strToInt(mappingProps.getProperty("count.of.processes.Y.axis"));
+	bool isNodeAware = (mappingProps.getProperty("node.aware.process.mapping") == "true");
+
+	// Run an ensemble of replicas, or a parameter sweep, on groups of the processes, if requested, instead of a single simulation on all of them.
+	// Each group uses the process grid from the properties file, as the autotuning would calibrate on all processes.
+	std::string sweepDesignType = mappingProps.getProperty("sweep.design");
+	int ensembleJobsCount = repast::strToInt(mappingProps.getProperty("ensemble.jobs"));
+	if( sweepDesignType == "latin.hypercube" || sweepDesignType == "sobol" || ensembleJobsCount > 0 )
+	{
+		std::string outputDirectory = mappingProps.getProperty("output.directory");
+		if( outputDirectory.empty() )
+		{
+			outputDirectory = "./output";
+		}
+		int baseSeed = repast::strToInt(mappingProps.getProperty("ensemble.base.seed"));
+
+		// The sweep runs each replicate of each point of its design as a job, and records the design for joining with the outputs of the jobs.
+		std::vector<EnsembleJob> ensembleJobs;
+		if( sweepDesignType == "latin.hypercube" || sweepDesignType == "sobol" )
+		{
+			SweepDesign sweepDesign(SweepDesign::parseParameters(mappingProps.getProperty("sweep.parameters")), 
+				(sweepDesignType == "sobol") ? SweepDesign::Sobol : SweepDesign::LatinHypercube, repast::strToInt(mappingProps.getProperty("sweep.points")), baseSeed);
+			ensembleJobs = sweepDesign.createJobs(repast::strToInt(mappingProps.getProperty("sweep.replicates")), baseSeed);
+			if( world.rank() == 0 )
+			{
+				sweepDesign.writeDesign(outputDirectory + "/sweep_design.csv", ensembleJobs);
+			}
+		}
+		else
+		{
+			ensembleJobs = EnsembleRunner::createReplicaJobs(ensembleJobsCount, baseSeed);
+		}
+
+		EnsembleRunner ensembleRunner(configFile, propsFile, argc, argv);
+		ensembleRunner.run(world, repast::strToInt(mappingProps.getProperty("ensemble.concurrent.replicas")), ensembleJobs, outputDirectory, 
+			processesCountXAxis, processesCountYAxis, isNodeAware, mappingProps.getProperty("ensemble.reuse.model") == "true");
+		return 0;
+	}
+
+	// Choose the shape of the process grid from short calibration runs, if requested. The chosen shape overrides the one in the properties file.
+	std::map<std::string, std::string> propertyOverrides;
+	if( mappingProps.getProperty("autotune.process.grid") == "true" )
+	{
+		std::string outputDirectory = mappingProps.getProperty("output.directory");
+		if( outputDirectory.empty() )
+		{
+			outputDirectory = "./output";
+		}
+
+		ProcessGridAutotune gridAutotune(configFile, propsFile, argc, argv);
+		gridAutotune.findFastestProcessGrid(world, repast::strToInt(mappingProps.getProperty("grid.dimension")), isNodeAware, 
+			repast::strToInt(mappingProps.getProperty("autotune.calibration.steps")), outputDirectory, processesCountXAxis, processesCountYAxis);
+
+		propertyOverrides["count.of.processes.X.axis"] = std::to_string(processesCountXAxis);
+		propertyOverrides["count.of.processes.Y.axis"] = std::to_string(processesCountYAxis);
+	}
+
+	// Repast hands the sections of the process grid out in rank order. To map them onto the nodes in blocks instead, the model runs
+	// on a communicator whose rank order is the order of the sections.
+	boost::mpi::communicator modelComm(ProcessGridMapping::createModelCommunicator(world, processesCountXAxis, processesCountYAxis, isNodeAware, true), boost::mpi::comm_take_ownership);
+
+	repast::RepastProcess::init(configFile, &modelComm);
 	
-	VirusCellModel* model = new VirusCellModel(propsFile, argc, argv, &world);
+	VirusCellModel* model = new VirusCellModel(propsFile, argc, argv, &modelComm, &propertyOverrides);
 	repast::ScheduleRunner& runner = repast::RepastProcess::instance()->getScheduleRunner();
 	
 	model->init();
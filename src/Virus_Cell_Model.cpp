@@ -2,33 +2,52 @@
 
 #include <stdio.h>
 #include <vector>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <thread>
 #include <boost/mpi.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
 #include "repast_hpc/AgentId.h"
 #include "repast_hpc/RepastProcess.h"
 #include "repast_hpc/Utilities.h"
 #include "repast_hpc/Properties.h"
 #include "repast_hpc/initialize_random.h"
+#include "repast_hpc/Random.h"
 #include "repast_hpc/Point.h"
-#include "repast_hpc/SVDataSetBuilder.h"
 
 #include "Virus_Cell_Model.h"
+#include "Population_Counters.h"
 
 /**********************
 *   VirusCellModel::VirusCellModel - Constructor for the VirusCellModel class.
 **********************/
-VirusCellModel::VirusCellModel(std::string propsFile, int argc, char** argv, boost::mpi::communicator* comm):
+VirusCellModel::VirusCellModel(std::string propsFile, int argc, char** argv, boost::mpi::communicator* comm, const std::map<std::string, std::string>* propertyOverrides):
 context(comm)
 {
+    modelComm = comm;
+
     // Read in the passed properties of the simmulation. Properties are the parameter values passed.
     props = new repast::Properties(propsFile, argc, argv, comm);
 
-    // Get the index of the final timestep of the simulation.
-    stopAt = repast::strToInt(props->getProperty("stop.at"));    
+    // Apply the properties overridden by the caller on top of the ones read in (e.g. the process grid tried by the autotuning).
+    if( propertyOverrides != nullptr )
+    {
+        std::map<std::string, std::string>::const_iterator overrideIter;
+        for( overrideIter = propertyOverrides->begin(); overrideIter != propertyOverrides->end(); ++overrideIter )
+        {
+            props->putProperty(overrideIter->first, overrideIter->second);
+        }
+    }
 
-    // Get the counts of agents which are to be initially created for each process.
-    countOfVirionAgents = repast::strToInt(props->getProperty("count.of.virions"));
-    countOfInnateImmuneCellAgents = repast::strToInt(props->getProperty("count.of.innate.immune.cells"));
-    countOfSpecialisedImmuneCellAgents = repast::strToInt(props->getProperty("count.of.specialised.immune.cells"));
+    // Start the counts of the local agents from 0, as the process may have run a model before (e.g. the calibration runs of the process grid autotuning).
+    PopulationCounters::instance()->reset(repast::RepastProcess::instance()->rank());
+
+    // Read the parameters of the simulation and of the agents.
+    readParameters();
 
     // Since we will be creating new virion agents, innate and specialised immune cell agents we need to track the last id index which was used.
     // That is to be incremented for each new agent of any of those types, to ensure that any new agents will have a unique id.
@@ -36,6 +55,263 @@ context(comm)
     currInnateImmuneCellAgendId = 0;
     currSpecialisedImmuneCellAgentId = 0;
 
+    // Initialize the random singleton with the distributions and random seed provided in the properties.
+    initializeRandom(*props, comm);
+
+    // All outputs of the model are written into the output directory (e.g. a directory of its own for each replica of an ensemble).
+    outputDirectory = props->getProperty("output.directory");
+    if( outputDirectory.empty() )
+    {
+        outputDirectory = "./output";
+    }
+
+    if(repast::RepastProcess::instance()->rank() == 1)
+    {
+        props->writeToSVFile(outputDirectory + "/simulation_parameters_record.csv");
+    }    
+
+
+    // Take the grid dimension sizes, number of dimensions and create the grid projection which will be inhabited by the agents.
+    gridDimensionSize = repast::strToInt(props->getProperty("grid.dimension"));
+    originCoordinate = -gridDimensionSize / 2;
+    repast::Point<double> origin(originCoordinate, originCoordinate);
+    repast::Point<double> extent(gridDimensionSize, gridDimensionSize);
+
+    repast::GridDimensions gridDimensions(origin, extent);
+
+    // Get the parameters about how we want to split the grid across the parallel processes
+    int processesCountXAxis = repast::strToInt(props->getProperty("count.of.processes.X.axis"));
+    int processesCountYAxis = repast::strToInt(props->getProperty("count.of.processes.Y.axis"));
+    std::vector<int> processDimensions;
+    processDimensions.push_back(processesCountXAxis);
+    processDimensions.push_back(processesCountYAxis);
+
+    // The grid projection will contain agents of type VirusCellInteractionAgents (the parent Agent class), so that it can facilitate all agents types
+    // Then we can use the agent type identifier in each agent ID, to cast them to the correct type of agent.
+    // Only the agent types which other processes read are copied into the buffer zones. The epithelial cells are the only agents queried
+    // beyond their own site, so by default the mobile agents are never copied, only moved to the process which owns their new location.
+    // The division and infection of neighbouring cells and the halo updates rely on the copies of the epithelial cells, so those are always copied,
+    // also when the property is missing (e.g. in an older properties file) or leaves them out.
+    std::set<int> replicatedAgentTypes = SelectiveBufferZoneSpace<VirusCellInteractionAgents, repast::WrapAroundBorders, 
+        repast::SimpleAdder<VirusCellInteractionAgents> >::parseAgentTypes(props->getProperty("buffer.zone.replicated.agent.types"));
+    if( replicatedAgentTypes.empty() )
+    {
+        replicatedAgentTypes.insert(0);
+    }
+    else if( replicatedAgentTypes.count(0) == 0 )
+    {
+        if( repast::RepastProcess::instance()->rank() == 0 )
+        {
+            std::cout<<"The buffer zone replicated agent types "<<props->getProperty("buffer.zone.replicated.agent.types")
+                <<" leave out the epithelial cells (type 0), which are needed in the buffer zones. They are replicated as well."<<std::endl;
+        }
+        replicatedAgentTypes.insert(0);
+    }
+    discreteGridSpace = new SelectiveBufferZoneSpace<VirusCellInteractionAgents, repast::WrapAroundBorders, repast::SimpleAdder<VirusCellInteractionAgents>>("AgentsDeiscreteSpace", 
+        gridDimensions, processDimensions, 1, comm, replicatedAgentTypes);
+
+    std::cout << "RANK " << repast::RepastProcess::instance()->rank() << " BOUNDS: " << discreteGridSpace->dimensions().origin() << " " << discreteGridSpace->dimensions().extents() << std::endl;
+    
+    // Add the grid to the shared context.
+   	context.addProjection(discreteGridSpace);
+
+    // Build the neighbourhood of this process in the process grid. It is used for all of the model's own cross-process communication,
+    // which only ever happens between neighbouring processes.
+    processNeighbourhood = new ProcessNeighbourhood(comm, processesCountXAxis, processesCountYAxis);
+    outgoingModificationRequests.resize(processNeighbourhood->getNeighbourCount());
+
+    int localExtentX = discreteGridSpace->dimensions().extents().getX();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
+    maxModificationRequestsPerNeighbour = 2 * (localExtentX + localExtentY);
+
+    // Get how often the copies of the agents in the buffer zones are to be synchronised with their originals.
+    haloExchangeInterval = std::max(1, repast::strToInt(props->getProperty("halo.exchange.interval")));
+    outgoingHaloUpdates.resize(processNeighbourhood->getNeighbourCount());
+
+    // The halo updates for the neighbouring processes on the same node can be passed through shared memory instead of messages.
+    // Each boundary cell is sent to a neighbour at most once per step, so the boundary cells bound the updates to a neighbour.
+    if( props->getProperty("shared.memory.halo.exchange") == "true" )
+    {
+        processNeighbourhood->enableSharedMemoryExchange(2 * (localExtentX + localExtentY) * sizeof(EpithelialCellHaloUpdate));
+    }
+    lastSentBoundaryCellStates.resize(localExtentX * localExtentY, -1);
+
+    // The migration and projection synchronisations can only be skipped if the buffer zones hold no copies of mobile agents,
+    // as otherwise the copies would need to follow the moves of their originals even within a process's section of the grid.
+    hasAgentLeftLocalSection = false;
+    hasSynchronisedProjection = false;
+    executedStepsCount = 0;
+    accumulatedStepTime = 0.0;
+    accumulatedSynchronisationTime = 0.0;
+    canSkipUnneededSynchronisation = !discreteGridSpace->isReplicatedAgentType(1) && !discreteGridSpace->isReplicatedAgentType(2) && !discreteGridSpace->isReplicatedAgentType(3);
+
+    // Open the output file for the per-timestep timing, if it has been requested. Only rank 0 records its timing.
+    recordTimestepTiming = (props->getProperty("record.timestep.timing") == "true");
+    if( recordTimestepTiming && repast::RepastProcess::instance()->rank() == 0 )
+    {
+        timestepTimingOutput.open((outputDirectory + "/timestep_timing.csv").c_str());
+        timestepTimingOutput<<"tick,boundary step (s),interior step (s),exposed exchange wait (s),hidden communication (s),hidden communication fraction,repast synchronisation (s),total (s)"<<std::endl;
+    }
+
+
+    // Create the writer of the spatial snapshots. Its position in the grid is the offset of this process's section from the grid origin.
+    snapshotWriter = new SpatialSnapshotWriter(comm, gridDimensionSize, gridDimensionSize, 
+        discreteGridSpace->dimensions().origin().getX() - originCoordinate, discreteGridSpace->dimensions().origin().getY() - originCoordinate, localExtentX, localExtentY);
+    snapshotTicks = SpatialSnapshotWriter::parseTicks(props->getProperty("snapshot.ticks"));
+    snapshotInterval = repast::strToInt(props->getProperty("snapshot.interval"));
+
+    // Create the in-situ summaries of the grid in blocks, for following the infection at a fine time resolution without the full snapshots.
+    rasterPyramid = new RasterPyramid(comm, gridDimensionSize, gridDimensionSize, 
+        discreteGridSpace->dimensions().origin().getX() - originCoordinate, discreteGridSpace->dimensions().origin().getY() - originCoordinate, localExtentX, localExtentY,
+        repast::strToInt(props->getProperty("raster.block.size")), outputDirectory + "/raster_pyramid.bin");
+    rasterInterval = repast::strToInt(props->getProperty("raster.interval"));
+
+    // Create the analysis of the plaques, if it has been requested. Its results are added to the recorded data.
+    plaqueAnalysis = nullptr;
+    if( props->getProperty("plaque.analysis") == "true" )
+    {
+        plaqueAnalysis = new PlaqueAnalysis(comm, processNeighbourhood, gridDimensionSize, gridDimensionSize, 
+            discreteGridSpace->dimensions().origin().getX() - originCoordinate, discreteGridSpace->dimensions().origin().getY() - originCoordinate, localExtentX, localExtentY);
+    }
+
+    // Create the tracking of the infection front, if it has been requested. The foci are given in the coordinates of the model.
+    frontTracker = nullptr;
+    if( props->getProperty("front.tracking") == "true" )
+    {
+        std::vector<std::pair<int, int> > foci = InfectionFrontTracker::parseFoci(props->getProperty("front.foci"));
+        for( size_t f = 0; f < foci.size(); ++f )
+        {
+            foci[f].first -= originCoordinate;
+            foci[f].second -= originCoordinate;
+        }
+        frontTracker = new InfectionFrontTracker(comm, gridDimensionSize, gridDimensionSize, foci, repast::strToInt(props->getProperty("front.velocity.window")));
+    }
+
+    // Create the checkpointing of the simulation. The simulation starts from tick 0, unless init restores it from a checkpoint.
+    checkpoint = new SimulationCheckpoint(comm, gridDimensionSize, gridDimensionSize, 
+        discreteGridSpace->dimensions().origin().getX() - originCoordinate, discreteGridSpace->dimensions().origin().getY() - originCoordinate, localExtentX, localExtentY);
+    checkpointInterval = repast::strToInt(props->getProperty("checkpoint.interval"));
+    startTick = 0;
+
+
+    // Create the agents' package providers and receivers which will be used for agent synchronisation across processes.
+    agentProvider = new VirusCellInteractionAgentsPackageProvider(&context);
+	agentReceiver = new VirusCellInteractionAgentsPackageReceiver(&context);
+
+
+    // Initialise Data collection
+	// Create the recorder, which sums the values of all data sources over the processes in one reduction per record.
+	agentsData = new AgentsDataRecorder(outputDirectory + "/agents_data.csv", comm);
+	
+	// Create the individual data sets to be added to the recorder. They read the population counters, which can be cross-checked against a scan of the agents for debugging.
+    bool isCrossChecked = (props->getProperty("population.counters.cross.check") == "true");
+	DataSource_EpithelialCellsCount* aliveEpithCellsCount_DataSource = new DataSource_EpithelialCellsCount(&context, isCrossChecked);
+	agentsData->addDataSource("# Alive Epithelial Cells", aliveEpithCellsCount_DataSource);
+
+    DataSource_InfectedEpithelialCellsCount* infectedEpithelialCellsCount_DataSource = new DataSource_InfectedEpithelialCellsCount(&context, isCrossChecked);
+    agentsData->addDataSource("# Infected Epithelial Cells", infectedEpithelialCellsCount_DataSource);
+    
+    DataSource_DeadEpithelialCellsCount* deadEpithelialCellsCount_DataSource = new DataSource_DeadEpithelialCellsCount(&context, isCrossChecked);
+    agentsData->addDataSource("# Dead Epithelial Cells", deadEpithelialCellsCount_DataSource);
+
+	DataSource_VirionsCount* virionsCount_DataSource = new DataSource_VirionsCount(&context, isCrossChecked);
+	agentsData->addDataSource("# Free Virions", virionsCount_DataSource);
+
+    DataSource_InnateImmuneCellsCount* innateImmuneCellsCount_DataSource = new DataSource_InnateImmuneCellsCount(&context, isCrossChecked);
+    agentsData->addDataSource("# Innate Immune Cells", innateImmuneCellsCount_DataSource);
+
+    DataSource_SpecialisedImmuneCellsCount* specialisedImmuneCellsCount_DataSource = new DataSource_SpecialisedImmuneCellsCount(&context, isCrossChecked);
+    agentsData->addDataSource("# Specialised Immune Cells", specialisedImmuneCellsCount_DataSource);
+
+    DataSource_TotalAgentsCount* totalAgentsCount_DataSource = new DataSource_TotalAgentsCount(&context, isCrossChecked);
+    agentsData->addDataSource("# Agents In Total", totalAgentsCount_DataSource);
+
+    // Add the plaque counts and areas, with the size distribution in bins doubling in size: 1, 2-3, 4-7, ...
+    if( plaqueAnalysis != nullptr )
+    {
+        agentsData->addDataSource("# Plaques", new DataSource_PlaqueCount(plaqueAnalysis));
+        agentsData->addDataSource("# Largest Plaque Area", new DataSource_LargestPlaqueArea(plaqueAnalysis));
+        for( int bin = 0; bin < plaqueAnalysis->getSizeBinsCount(); ++bin )
+        {
+            int smallestSize = 1 << bin;
+            std::string sizeRange = (bin == 0) ? "1" : std::to_string(smallestSize) + "-" + std::to_string(2 * smallestSize - 1);
+            agentsData->addDataSource("# Plaques Of Size " + sizeRange, new DataSource_PlaqueSizeCount(plaqueAnalysis, bin));
+        }
+    }
+
+    // Add the front of each focus, in hundredths of a site.
+    if( frontTracker != nullptr )
+    {
+        for( int focus = 0; focus < frontTracker->getFociCount(); ++focus )
+        {
+            std::string focusName = "Focus " + std::to_string(focus + 1) + " ";
+            agentsData->addDataSource(focusName + "Centroid X (x100)", new DataSource_InfectionFront(frontTracker, focus, DataSource_InfectionFront::CentroidX, originCoordinate));
+            agentsData->addDataSource(focusName + "Centroid Y (x100)", new DataSource_InfectionFront(frontTracker, focus, DataSource_InfectionFront::CentroidY, originCoordinate));
+            agentsData->addDataSource(focusName + "Radius Of Gyration (x100)", new DataSource_InfectionFront(frontTracker, focus, DataSource_InfectionFront::RadiusOfGyration, originCoordinate));
+            agentsData->addDataSource(focusName + "Max Infected Radius (x100)", new DataSource_InfectionFront(frontTracker, focus, DataSource_InfectionFront::MaxInfectedRadius, originCoordinate));
+            agentsData->addDataSource(focusName + "Front Velocity (x100 per tick)", new DataSource_InfectionFront(frontTracker, focus, DataSource_InfectionFront::FrontVelocity, originCoordinate));
+        }
+    }
+
+    // Write the records to the binary columnar file as well, if requested. Its header identifies the run by the hash of all parameters and the random seed.
+    if( props->getProperty("agents.data.columnar.output") == "true" )
+    {
+        agentsData->enableColumnarOutput(outputDirectory + "/agents_data.vcts", ColumnarTimeSeriesWriter::hashText(getParametersText()), repast::Random::instance()->seed());
+    }
+
+    // Stop the simulation early, once its outcome is settled, if requested.
+    terminationCriteria = nullptr;
+    createTerminationCriteria();
+}
+
+
+
+/**********************
+*   VirusCellModel::createTerminationCriteria - Creates the termination criteria from the properties, and has the recorder check them on its records.
+*   They are only created if any of them is enabled, as the recorder then needs to sum its records onto all processes.
+*   The criteria are checked on the population columns, which are the first columns of the records.
+**********************/
+void VirusCellModel::createTerminationCriteria()
+{
+    delete terminationCriteria;
+    terminationCriteria = nullptr;
+
+    const int aliveCellsColumn = 0;
+    const int infectedCellsColumn = 1;
+    const int virionsColumn = 3;
+    std::vector<int> populationColumns = { 0, 1, 2, 3, 4, 5 };
+
+    TerminationCriteria* criteria = new TerminationCriteria(aliveCellsColumn, infectedCellsColumn, virionsColumn, populationColumns,
+        repast::strToInt(props->getProperty("termination.extinction.ticks")), props->getProperty("termination.tissue.destroyed") == "true",
+        repast::strToInt(props->getProperty("termination.steady.state.window")), repast::strToDouble(props->getProperty("termination.steady.state.tolerance")),
+        outputDirectory + "/termination.csv");
+    if( criteria->isEnabled() )
+    {
+        terminationCriteria = criteria;
+    }
+    else
+    {
+        delete criteria;
+    }
+
+    agentsData->setTerminationCriteria(terminationCriteria);
+}
+
+
+
+/**********************
+*   VirusCellModel::readParameters - Reads the parameters of the simulation and of the agents from the properties.
+**********************/
+void VirusCellModel::readParameters()
+{
+    // Get the index of the final timestep of the simulation.
+    stopAt = repast::strToInt(props->getProperty("stop.at"));    
+
+    // Get the counts of agents which are to be initially created for each process.
+    countOfVirionAgents = repast::strToInt(props->getProperty("count.of.virions"));
+    countOfInnateImmuneCellAgents = repast::strToInt(props->getProperty("count.of.innate.immune.cells"));
+    countOfSpecialisedImmuneCellAgents = repast::strToInt(props->getProperty("count.of.specialised.immune.cells"));
+
     // Epithelial cell agents parameters read.
     epithCellAvgLifespan = repast::strToInt(props->getProperty("epithelial.cell.average.lifespan"));
     epithCellLifespanStdev = repast::strToInt(props->getProperty("epithelial.cell.lifespan.standard.dev"));
@@ -75,89 +351,157 @@ context(comm)
     specialisedImmuneCellInfectedCellRecognitionProb = repast::strToDouble(props->getProperty("specialised.immune.cell.infected.cell.recognition.probability"));
     specialisedImmuneCellInfectedCellEliminationProb = repast::strToDouble(props->getProperty("specialised.immune.cell.infected.cell.elimination.probability"));
     specialisedImmuneCellRecruitRateOfSpecCell = repast::strToDouble(props->getProperty("specialised.immune.cell.recruit.rate.of.specialised.cell"));
+}
 
-    // Initialize the random singleton with the distributions and random seed provided in the properties.
-    initializeRandom(*props, comm);
-
-    if(repast::RepastProcess::instance()->rank() == 1)
-    {
-        props->writeToSVFile("./output/simulation_parameters_record.csv");
-    }    
 
 
-    // Take the grid dimension sizes, number of dimensions and create the grid projection which will be inhabited by the agents.
-    gridDimensionSize = repast::strToInt(props->getProperty("grid.dimension"));
-    int originCoordinate = -gridDimensionSize / 2;
-    repast::Point<double> origin(originCoordinate, originCoordinate);
-    repast::Point<double> extent(gridDimensionSize, gridDimensionSize);
+/**********************
+*   VirusCellModel::~VirusCellModel - Destructor for the VirusCellModel class.
+**********************/
+VirusCellModel::~VirusCellModel(){
+		delete props;
+        delete agentProvider;
+        delete agentReceiver;
+        delete processNeighbourhood;
+        delete snapshotWriter;
+        delete rasterPyramid;
+        delete plaqueAnalysis;
+        delete frontTracker;
+        delete checkpoint;
+
+        // Deleting the recorder will also delete all of its data sources
+        delete agentsData;
+        delete terminationCriteria;
+}
 
-    repast::GridDimensions gridDimensions(origin, extent);
 
-    // Get the parameters about how we want to split the grid across the parallel processes
-    int processesCountXAxis = repast::strToInt(props->getProperty("count.of.processes.X.axis"));
-    int processesCountYAxis = repast::strToInt(props->getProperty("count.of.processes.Y.axis"));
-    std::vector<int> processDimensions;
-    processDimensions.push_back(processesCountXAxis);
-    processDimensions.push_back(processesCountYAxis);
 
-    // The grid projection will contain agents of type VirusCellInteractionAgents (the parent Agent class), so that it can facilitate all agents types
-    // Then we can use the agent type identifier in each agent ID, to cast them to the correct type of agent.
-    discreteGridSpace = new repast::SharedDiscreteSpace<VirusCellInteractionAgents, repast::WrapAroundBorders, repast::SimpleAdder<VirusCellInteractionAgents>>("AgentsDeiscreteSpace", gridDimensions, processDimensions, 1, comm);
+/**********************
+*   VirusCellModel::reset - Prepares the model for a new run with the passed parameters and random seed, without creating it again.
+*   All agents are removed, and the counters, buffers, analyses and outputs of the model are reset for the new run, while the grid,
+*   the communicators and all allocated buffers are kept. The properties which shape these (the grid and process grid, the buffer zones,
+*   the enabled analyses and the foci) cannot be changed by the reset. The new run is started with init and initSchedule as usual,
+*   on a new Repast process, as the schedule of the previous run cannot be rewound. Needs to be called by all processes.
+**********************/
+void VirusCellModel::reset(const std::map<std::string, std::string>& parameters, int seed)
+{
+    int rank = repast::RepastProcess::instance()->rank();
 
-    std::cout << "RANK " << repast::RepastProcess::instance()->rank() << " BOUNDS: " << discreteGridSpace->dimensions().origin() << " " << discreteGridSpace->dimensions().extents() << std::endl;
-    
-    // Add the grid to the shared context.
-   	context.addProjection(discreteGridSpace);
+    // Remove the copies in the buffer zone without notifying their processes, as those remove the originals themselves.
+    std::vector<VirusCellInteractionAgents*> theAgents;
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::NON_LOCAL, theAgents);
+    for( size_t i = 0; i < theAgents.size(); ++i )
+    {
+        context.importedAgentRemoved(theAgents[i]->getId());
+    }
+    theAgents.clear();
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theAgents);
+    for( size_t i = 0; i < theAgents.size(); ++i )
+    {
+        context.removeAgent(theAgents[i]->getId());
+    }
+    PopulationCounters::instance()->reset(rank);
 
+    // Apply the new parameters and seed.
+    std::map<std::string, std::string>::const_iterator parameterIter;
+    for( parameterIter = parameters.begin(); parameterIter != parameters.end(); ++parameterIter )
+    {
+        props->putProperty(parameterIter->first, parameterIter->second);
+    }
+    props->putProperty("random.seed", std::to_string(seed));
+    readParameters();
+    initializeRandom(*props, modelComm);
 
-    // Create the agents' package providers and receivers which will be used for agent synchronisation across processes.
-    agentProvider = new VirusCellInteractionAgentsPackageProvider(&context);
-	agentReceiver = new VirusCellInteractionAgentsPackageReceiver(&context);
+    currVirionAgentId = 0;
+    currInnateImmuneCellAgendId = 0;
+    currSpecialisedImmuneCellAgentId = 0;
+    countVirsWhichManagedToInfectACell = 0;
+    executedStepsCount = 0;
+    accumulatedStepTime = 0.0;
+    accumulatedSynchronisationTime = 0.0;
+    hasAgentLeftLocalSection = false;
+    hasSynchronisedProjection = false;
+    startTick = 0;
+
+    for( size_t n = 0; n < outgoingModificationRequests.size(); ++n )
+    {
+        outgoingModificationRequests[n].clear();
+        outgoingHaloUpdates[n].clear();
+    }
+    incomingModificationRequests.clear();
+    incomingHaloUpdates.clear();
+    std::fill(lastSentBoundaryCellStates.begin(), lastSentBoundaryCellStates.end(), -1);
+    boundaryEpithelialCells.clear();
+    boundaryEpithelialCellSet.clear();
+
+    // Reset the outputs, into the output directory of the new run.
+    outputDirectory = props->getProperty("output.directory");
+    if( outputDirectory.empty() )
+    {
+        outputDirectory = "./output";
+    }
+    if( rank == 1 )
+    {
+        props->writeToSVFile(outputDirectory + "/simulation_parameters_record.csv");
+    }
 
+    timestepTimingOutput.close();
+    recordTimestepTiming = (props->getProperty("record.timestep.timing") == "true");
+    if( recordTimestepTiming && rank == 0 )
+    {
+        timestepTimingOutput.open((outputDirectory + "/timestep_timing.csv").c_str());
+        timestepTimingOutput<<"tick,boundary step (s),interior step (s),exposed exchange wait (s),hidden communication (s),hidden communication fraction,repast synchronisation (s),total (s)"<<std::endl;
+    }
 
-    // Initialise Data collection
-	// Create the data set builder
-	std::string fileOutputName("./output/agents_data.csv");
-	repast::SVDataSetBuilder dataBuilder(fileOutputName.c_str(), ",", repast::RepastProcess::instance()->getScheduleRunner().schedule());
-	
-	// Create the individual data sets to be added to the builder
-	DataSource_EpithelialCellsCount* aliveEpithCellsCount_DataSource = new DataSource_EpithelialCellsCount(&context);
-	dataBuilder.addDataSource(createSVDataSource("# Alive Epithelial Cells", aliveEpithCellsCount_DataSource, std::plus<int>()));
+    snapshotTicks = SpatialSnapshotWriter::parseTicks(props->getProperty("snapshot.ticks"));
+    snapshotInterval = repast::strToInt(props->getProperty("snapshot.interval"));
+    rasterInterval = repast::strToInt(props->getProperty("raster.interval"));
+    rasterPyramid->restart(outputDirectory + "/raster_pyramid.bin");
+    checkpointInterval = repast::strToInt(props->getProperty("checkpoint.interval"));
+    if( frontTracker != nullptr )
+    {
+        frontTracker->reset();
+    }
 
-    DataSource_InfectedEpithelialCellsCount* infectedEpithelialCellsCount_DataSource = new DataSource_InfectedEpithelialCellsCount(&context);
-    dataBuilder.addDataSource(createSVDataSource("# Infected Epithelial Cells", infectedEpithelialCellsCount_DataSource, std::plus<int>()));
-    
-    DataSource_DeadEpithelialCellsCount* deadEpithelialCellsCount_DataSource = new DataSource_DeadEpithelialCellsCount(&context);
-    dataBuilder.addDataSource(createSVDataSource("# Dead Epithelial Cells", deadEpithelialCellsCount_DataSource, std::plus<int>()));
+    agentsData->restart(outputDirectory + "/agents_data.csv");
+    if( props->getProperty("agents.data.columnar.output") == "true" )
+    {
+        agentsData->enableColumnarOutput(outputDirectory + "/agents_data.vcts", ColumnarTimeSeriesWriter::hashText(getParametersText()), repast::Random::instance()->seed());
+    }
+    createTerminationCriteria();
+}
 
-	DataSource_VirionsCount* virionsCount_DataSource = new DataSource_VirionsCount(&context);
-	dataBuilder.addDataSource(createSVDataSource("# Free Virions", virionsCount_DataSource, std::plus<int>()));
 
-    DataSource_InnateImmuneCellsCount* innateImmuneCellsCount_DataSource = new DataSource_InnateImmuneCellsCount(&context);
-    dataBuilder.addDataSource(createSVDataSource("# Innate Immune Cells", innateImmuneCellsCount_DataSource, std::plus<int>()));
 
-    DataSource_SpecialisedImmuneCellsCount* specialisedImmuneCellsCount_DataSource = new DataSource_SpecialisedImmuneCellsCount(&context);
-    dataBuilder.addDataSource(createSVDataSource("# Specialised Immune Cells", specialisedImmuneCellsCount_DataSource, std::plus<int>()));
+/**********************
+*   VirusCellModel::getParametersText - Gets all properties of the model as key=value lines, sorted by key, so equal parameters always give equal text.
+**********************/
+std::string VirusCellModel::getParametersText() const
+{
+    std::map<std::string, std::string> sortedProperties;
+    for( std::set<std::string>::const_iterator keyIter = props->keys_begin(); keyIter != props->keys_end(); ++keyIter )
+    {
+        sortedProperties[*keyIter] = props->getProperty(*keyIter);
+    }
 
-    DataSource_TotalAgentsCount* totalAgentsCount_DataSource = new DataSource_TotalAgentsCount(&context);
-    dataBuilder.addDataSource(createSVDataSource("# Agents In Total", totalAgentsCount_DataSource, std::plus<int>()));
+    std::string parametersText;
+    std::map<std::string, std::string>::const_iterator propertyIter;
+    for( propertyIter = sortedProperties.begin(); propertyIter != sortedProperties.end(); ++propertyIter )
+    {
+        parametersText += propertyIter->first + "=" + propertyIter->second + "\n";
+    }
 
-	// Use the builder to create the data set
-	agentsData = dataBuilder.createDataSet();   
+    return parametersText;
 }
 
 
 
 /**********************
-*   VirusCellModel::~VirusCellModel - Destructor for the VirusCellModel class.
+*   getFirstTickAfter - Gets the first tick after the passed one which is a multiple of the interval.
 **********************/
-VirusCellModel::~VirusCellModel(){
-		delete props;
-        delete agentProvider;
-        delete agentReceiver;
-
-        // Deleting the dataset, will also automatically delete all individual datasets/datasources
-        delete agentsData;
+static int getFirstTickAfter(int tick, int interval)
+{
+    return (tick / interval + 1) * interval;
 }
 
 
@@ -169,16 +513,55 @@ void VirusCellModel::initSchedule(repast::ScheduleRunner& runner)
 {
 	runner.scheduleStop(stopAt);
 
+    // All events start after startTick, which is 0 unless the simulation has been restored from a checkpoint. The events on an interval
+    // keep their ticks, so a restarted simulation writes its outputs at the same ticks as an uninterrupted one.
+
     // Schedule agents to act on each tick.
-    runner.scheduleEvent(1, 1, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::executeTimestep)));
+    runner.scheduleEvent(startTick + 1, 1, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::executeTimestep)));
 
     // Schedule Data collection. Record data on each tick and write all recorded records on every 3 ticks.
-	runner.scheduleEvent(0.1, 1, repast::Schedule::FunctorPtr(new repast::MethodFunctor<repast::DataSet>(agentsData, &repast::DataSet::record)));
-	runner.scheduleEvent(0.2, 3, repast::Schedule::FunctorPtr(new repast::MethodFunctor<repast::DataSet>(agentsData, &repast::DataSet::write)));
+    // Each record is taken right after the timestep and its reduction completes during the next timestep, at the next record or write.
+    // The plaques and the infection front are analysed just before the record, so it holds their counts of the same tick.
+    if( plaqueAnalysis != nullptr )
+    {
+        runner.scheduleEvent(startTick + 0.05, 1, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::analysePlaques)));
+    }
+    if( frontTracker != nullptr )
+    {
+        runner.scheduleEvent(startTick + 0.06, 1, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::trackInfectionFront)));
+    }
+	runner.scheduleEvent(startTick + 0.1, 1, repast::Schedule::FunctorPtr(new repast::MethodFunctor<AgentsDataRecorder>(agentsData, &AgentsDataRecorder::record)));
+	runner.scheduleEvent(startTick + 0.2, 3, repast::Schedule::FunctorPtr(new repast::MethodFunctor<AgentsDataRecorder>(agentsData, &AgentsDataRecorder::write)));
+
+    runner.scheduleEvent(startTick + 1.3, 1, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::printEndOfTimestep)));
+
+    // Schedule the spatial snapshots, taken after the step of their tick, at each of the listed ticks and on the interval.
+    std::set<int>::iterator snapshotTickIter;
+    for( snapshotTickIter = snapshotTicks.begin(); snapshotTickIter != snapshotTicks.end(); ++snapshotTickIter )
+    {
+        if( *snapshotTickIter > startTick && (snapshotInterval <= 0 || *snapshotTickIter % snapshotInterval != 0) )
+        {
+            runner.scheduleEvent(*snapshotTickIter + 0.15, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::writeSpatialSnapshot)));
+        }
+    }
+    if( snapshotInterval > 0 )
+    {
+        runner.scheduleEvent(getFirstTickAfter(startTick, snapshotInterval) + 0.15, snapshotInterval, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::writeSpatialSnapshot)));
+    }
 
-    runner.scheduleEvent(1.3, 1, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::printEndOfTimestep)));
+    // Schedule the frames of the block summaries, also taken after the step of their tick.
+    if( rasterInterval > 0 )
+    {
+        runner.scheduleEvent(getFirstTickAfter(startTick, rasterInterval) + 0.12, rasterInterval, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::writeRasterFrame)));
+    }
+
+    // Schedule the checkpoints, taken after all outputs of their tick.
+    if( checkpointInterval > 0 )
+    {
+        runner.scheduleEvent(getFirstTickAfter(startTick, checkpointInterval) + 0.18, checkpointInterval, repast::Schedule::FunctorPtr(new repast::MethodFunctor<VirusCellModel> (this, &VirusCellModel::writeCheckpoint)));
+    }
 
-	runner.scheduleEndEvent(repast::Schedule::FunctorPtr(new repast::MethodFunctor<repast::DataSet>(agentsData, &repast::DataSet::write)));
+	runner.scheduleEndEvent(repast::Schedule::FunctorPtr(new repast::MethodFunctor<AgentsDataRecorder>(agentsData, &AgentsDataRecorder::write)));
 }
 
 
@@ -190,17 +573,28 @@ void VirusCellModel::init()
 {
     int rank = repast::RepastProcess::instance()->rank();
 
-    // Create the epithelial cell agents in the model
-    int epithelialCellIndex = 0;
-    for( int x = 0; x < discreteGridSpace->dimensions().extents().getX(); ++x)
+    // Restore the simulation from a checkpoint, if requested, instead of creating the agents. A fork restores the agents of the checkpoint,
+    // but continues with the parameters and random seed of this run.
+    bool isFork = props->getProperty("fork.from.checkpoint") != "";
+    std::string checkpointFileName = isFork ? props->getProperty("fork.from.checkpoint") : props->getProperty("restart.from.checkpoint");
+    if( !checkpointFileName.empty() )
     {
-        for( int y = 0; y < discreteGridSpace->dimensions().extents().getY(); ++y)
+        if( restoreFromCheckpoint(checkpointFileName, isFork) )
         {
-            initialiseEpithelialCellAgent(epithelialCellIndex, x, y, false, nullptr);
-            ++epithelialCellIndex;
+            findBoundaryEpithelialCells();
+            return;
+        }
+
+        if( rank == 0 )
+        {
+            std::cout<<"Could not restart from the checkpoint "<<checkpointFileName<<", starting a new simulation instead."<<std::endl;
         }
     }
 
+    // Create the epithelial cell agents in the model
+    initialiseTissue();
+    findBoundaryEpithelialCells();
+
     // Create the initial virion agents in the model
     for( int i = 0; i < countOfVirionAgents; ++i )
     {
@@ -226,26 +620,267 @@ void VirusCellModel::init()
 
 
 /**********************
-*   VirusCellModel::initialiseEpithelialCellAgent - Initialises an epithelial cell agent and places it on the grid.
+*   VirusCellModel::initialiseTissue - Creates the epithelial cell agents of this process's section of the grid. If the tissue cache is enabled,
+*   the tissue is mapped from the cache when it holds one drawn with the same epithelial parameters, grid, section and seed, and otherwise
+*   it is drawn and written to the cache for the later runs. The cache is only of use with a fixed random seed.
+*   The tissue is drawn either cell by cell from the random number engine of the process, or in bulk over several threads if enabled.
 **********************/
-void VirusCellModel::initialiseEpithelialCellAgent( int epithelialCellIndex, int xCoor, int yCoor, bool isExistingAgentObject, EpithelialCellAgent* theExistingCellObject )
+void VirusCellModel::initialiseTissue()
 {
     int rank = repast::RepastProcess::instance()->rank();
+    int localExtentX = discreteGridSpace->dimensions().extents().getX();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
+    bool isBulkInitialisation = (props->getProperty("bulk.tissue.initialisation") == "true");
 
-    // Allocate an arbitrary lifespan to the cell
-    repast::NormalGenerator lifespanGenerator = repast::Random::instance()->createNormalGenerator(epithCellAvgLifespan, epithCellLifespanStdev);
-    int cellLifespan = 0;
-    while(cellLifespan < 1)
+    std::string tissueCacheDirectory = props->getProperty("tissue.cache.directory");
+    if( tissueCacheDirectory.empty() )
     {
-        cellLifespan = lifespanGenerator.next();
-    }         
+        if( isBulkInitialisation )
+        {
+            std::vector<TissueCellRecord> cellRecords;
+            drawTissueInBulk(cellRecords);
+            createTissueFromRecords(cellRecords.data());
+            return;
+        }
 
+        int epithelialCellIndex = 0;
+        for( int x = 0; x < localExtentX; ++x)
+        {
+            for( int y = 0; y < localExtentY; ++y)
+            {
+                initialiseEpithelialCellAgent(epithelialCellIndex, x, y, false, nullptr);
+                ++epithelialCellIndex;
+            }
+        }
+        return;
+    }
 
-    int cellAge = 0;
-    // Alloacte an arbitrary age to the cell if there is not an already existing object. If there is no existing object, that means we are just creating
-    // the objects of all agents at the start of the simulation. Then we have arbitrary ages for each cell, rather than 0.
-    // The age will remain 0, if there is an existing agent object, which means we are handling division. That will be a completely fresh cell with 0 age.
-    if(!isExistingAgentObject)
+    // The key of the tissue covers all the epithelial parameters, even the ones not drawn, as an added parameter may be drawn in the future.
+    std::stringstream keyText;
+    std::stringstream parametersStream(getParametersText());
+    std::string parameterLine;
+    while( std::getline(parametersStream, parameterLine) )
+    {
+        if( parameterLine.compare(0, 11, "epithelial.") == 0 )
+        {
+            keyText<<parameterLine<<"\n";
+        }
+    }
+    keyText<<"grid="<<gridDimensionSize<<"\nprocesses="<<repast::RepastProcess::instance()->worldSize()
+           <<"\nsection="<<discreteGridSpace->dimensions().origin()<<discreteGridSpace->dimensions().extents()
+           <<"\nseed="<<repast::Random::instance()->seed()<<"\nbulk="<<isBulkInitialisation<<"\n";
+
+    TissueCache tissueCache(tissueCacheDirectory, ColumnarTimeSeriesWriter::hashText(keyText.str()), rank);
+    if( tissueCache.load(localExtentX * localExtentY) )
+    {
+        createTissueFromRecords(&tissueCache.getCell(0));
+
+        // Continue from the random numbers which followed the drawing of the tissue, as if it had just been drawn.
+        std::istringstream randomEngineState(tissueCache.getRandomEngineState());
+        randomEngineState>>repast::Random::instance()->engine();
+        return;
+    }
+
+    std::vector<TissueCellRecord> cellRecords;
+    if( isBulkInitialisation )
+    {
+        drawTissueInBulk(cellRecords);
+        createTissueFromRecords(cellRecords.data());
+    }
+    else
+    {
+        cellRecords.reserve(localExtentX * localExtentY);
+        int epithelialCellIndex = 0;
+        for( int x = 0; x < localExtentX; ++x)
+        {
+            for( int y = 0; y < localExtentY; ++y)
+            {
+                initialiseEpithelialCellAgent(epithelialCellIndex, x, y, false, nullptr);
+
+                EpithelialCellAgent* newEpithelialCell = static_cast<EpithelialCellAgent*>(context.getAgent(repast::AgentId(epithelialCellIndex, rank, 0, rank)));
+                TissueCellRecord cell;
+                cell.lifespan = newEpithelialCell->getLifespan();
+                cell.age = newEpithelialCell->getAge();
+                cell.timeSinceLastDivision = newEpithelialCell->getTimeSinceLastDivision();
+                cell.infectedLifespan = newEpithelialCell->getInfectedLifespan();
+                cell.divisionRate = newEpithelialCell->getDivisionRate();
+                cell.releaseDelay = newEpithelialCell->getReleaseDelay();
+                cell.displayVirProteinsDelay = newEpithelialCell->getDisplayVirProteinsDelay();
+                cell.virionReleaseRate = newEpithelialCell->getVirionReleaseRate();
+                cellRecords.push_back(cell);
+                ++epithelialCellIndex;
+            }
+        }
+    }
+
+    std::ostringstream randomEngineState;
+    randomEngineState<<repast::Random::instance()->engine();
+    if( !tissueCache.store(cellRecords, randomEngineState.str()) )
+    {
+        std::cout<<"RANK "<<rank<<" could not write its tissue to the cache in "<<tissueCacheDirectory<<"."<<std::endl;
+    }
+}
+
+
+
+/**********************
+*   VirusCellModel::createTissueFromRecords - Creates an epithelial cell agent on each site of this process's section of the grid from its drawn parameters.
+*   The records are in the order of the cell indices, along the Y axis within each column of the section.
+**********************/
+void VirusCellModel::createTissueFromRecords(const TissueCellRecord* cellRecords)
+{
+    int rank = repast::RepastProcess::instance()->rank();
+    int localExtentX = discreteGridSpace->dimensions().extents().getX();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
+
+    int epithelialCellIndex = 0;
+    for( int x = 0; x < localExtentX; ++x)
+    {
+        for( int y = 0; y < localExtentY; ++y)
+        {
+            const TissueCellRecord& cell = cellRecords[epithelialCellIndex];
+
+            repast::AgentId newAgentId(epithelialCellIndex, rank, 0);
+            newAgentId.currentRank(rank);
+            EpithelialCellAgent* newEpithelialCell = new EpithelialCellAgent(newAgentId, cell.lifespan, cell.age, cell.infectedLifespan, cell.divisionRate, 
+                cell.timeSinceLastDivision, cell.releaseDelay, cell.displayVirProteinsDelay, extracellularVirusReleaseProb, cellToCellTransmissionProb, cell.virionReleaseRate);
+            context.addAgent(newEpithelialCell);
+
+            repast::Point<int> agentLocation(x + discreteGridSpace->dimensions().origin().getX(), y + discreteGridSpace->dimensions().origin().getY());
+            discreteGridSpace->moveTo(newAgentId, agentLocation);
+            ++epithelialCellIndex;
+        }
+    }
+}
+
+
+
+/**********************
+*   VirusCellModel::drawTissueInBulk - Draws the parameters of all epithelial cells of this process's section of the grid, spreading the columns
+*   of the section over several threads (tissue.initialisation.threads, or all hardware threads if 0).
+**********************/
+void VirusCellModel::drawTissueInBulk(std::vector<TissueCellRecord>& cellRecords)
+{
+    int localExtentX = discreteGridSpace->dimensions().extents().getX();
+    cellRecords.resize(localExtentX * discreteGridSpace->dimensions().extents().getY());
+
+    int threadsCount = repast::strToInt(props->getProperty("tissue.initialisation.threads"));
+    if( threadsCount <= 0 )
+    {
+        threadsCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadsCount = std::min(threadsCount, localExtentX);
+
+    std::vector<std::thread> drawingThreads;
+    for( int t = 1; t < threadsCount; ++t )
+    {
+        drawingThreads.push_back(std::thread(&VirusCellModel::drawTissueColumns, this, t, threadsCount, std::ref(cellRecords)));
+    }
+    drawTissueColumns(0, threadsCount, cellRecords);
+
+    for( size_t t = 0; t < drawingThreads.size(); ++t )
+    {
+        drawingThreads[t].join();
+    }
+}
+
+
+
+/**********************
+*   VirusCellModel::drawTissueColumns - Draws the parameters of the epithelial cells of every columnsStep-th column of the section, starting from firstColumn.
+*   Each column has its own random number engine, seeded from the random seed, the rank and the column, so the tissue does not depend on the count
+*   of threads. The parameters are drawn the same way as for a single cell in initialiseEpithelialCellAgent, but from different random numbers.
+**********************/
+void VirusCellModel::drawTissueColumns(int firstColumn, int columnsStep, std::vector<TissueCellRecord>& cellRecords) const
+{
+    int rank = repast::RepastProcess::instance()->rank();
+    int localExtentX = discreteGridSpace->dimensions().extents().getX();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
+    uint32_t seed = repast::Random::instance()->seed();
+
+    boost::random::normal_distribution<double> lifespanDist(epithCellAvgLifespan, epithCellLifespanStdev);
+    boost::random::normal_distribution<double> infectedLifespanDist(epithCellInfectedLifespanAvg, epithCellInfectedLifespanStdev);
+    boost::random::normal_distribution<double> divisionRateDist(epithCellDivisionRateAvg, epithCellDivisionRateStdev);
+    boost::random::normal_distribution<double> displayVirProtDelayDist(epithCellDispViralPeptidesDelayAvg, epithCellDispViralPeptidesDelayStdev);
+    boost::random::normal_distribution<double> releaseDelayDist(epithCellVirionReleaseDelayAvg, epithCellVirionReleaseDelayStdev);
+    boost::random::normal_distribution<double> virionReleaseRateDist(epithCellVirionReleaseRateAvg, epithCellVirionReleaseRateStdev);
+
+    for( int x = firstColumn; x < localExtentX; x += columnsStep )
+    {
+        std::seed_seq columnSeed = { seed, static_cast<uint32_t>(rank), static_cast<uint32_t>(x) };
+        boost::mt19937 columnEngine(columnSeed);
+
+        for( int y = 0; y < localExtentY; ++y )
+        {
+            TissueCellRecord& cell = cellRecords[x * localExtentY + y];
+
+            int cellLifespan = 0;
+            while( cellLifespan < 1 )
+            {
+                cellLifespan = lifespanDist(columnEngine);
+            }
+            cell.lifespan = cellLifespan;
+            cell.age = boost::random::uniform_int_distribution<int>(0, cellLifespan)(columnEngine);
+
+            int infectedCellLifespan = 0;
+            while( infectedCellLifespan < 1 )
+            {
+                infectedCellLifespan = infectedLifespanDist(columnEngine);
+            }
+            cell.infectedLifespan = infectedCellLifespan;
+
+            int divisionRate = 0;
+            while( divisionRate < 1 )
+            {
+                divisionRate = divisionRateDist(columnEngine);
+            }
+            cell.divisionRate = divisionRate;
+            cell.timeSinceLastDivision = boost::random::uniform_int_distribution<int>(0, divisionRate)(columnEngine);
+
+            cell.displayVirProteinsDelay = displayVirProtDelayDist(columnEngine);
+            while( cell.displayVirProteinsDelay < 1 )
+            {
+                cell.displayVirProteinsDelay = displayVirProtDelayDist(columnEngine);
+            }
+
+            cell.releaseDelay = releaseDelayDist(columnEngine);
+            while( cell.releaseDelay < 1 && cell.releaseDelay <= cell.displayVirProteinsDelay )
+            {
+                cell.releaseDelay = releaseDelayDist(columnEngine);
+            }
+
+            cell.virionReleaseRate = virionReleaseRateDist(columnEngine);
+            while( cell.virionReleaseRate < 0.1 )
+            {
+                cell.virionReleaseRate = virionReleaseRateDist(columnEngine);
+            }
+        }
+    }
+}
+
+
+
+/**********************
+*   VirusCellModel::initialiseEpithelialCellAgent - Initialises an epithelial cell agent and places it on the grid.
+**********************/
+void VirusCellModel::initialiseEpithelialCellAgent( int epithelialCellIndex, int xCoor, int yCoor, bool isExistingAgentObject, EpithelialCellAgent* theExistingCellObject )
+{
+    int rank = repast::RepastProcess::instance()->rank();
+
+    // Allocate an arbitrary lifespan to the cell
+    repast::NormalGenerator lifespanGenerator = repast::Random::instance()->createNormalGenerator(epithCellAvgLifespan, epithCellLifespanStdev);
+    int cellLifespan = 0;
+    while(cellLifespan < 1)
+    {
+        cellLifespan = lifespanGenerator.next();
+    }         
+
+
+    int cellAge = 0;
+    // Alloacte an arbitrary age to the cell if there is not an already existing object. If there is no existing object, that means we are just creating
+    // the objects of all agents at the start of the simulation. Then we have arbitrary ages for each cell, rather than 0.
+    // The age will remain 0, if there is an existing agent object, which means we are handling division. That will be a completely fresh cell with 0 age.
+    if(!isExistingAgentObject)
     {
         repast::IntUniformGenerator ageGenerator = repast::Random::instance()->createUniIntGenerator(0, cellLifespan);
         cellAge = ageGenerator.next();
@@ -334,269 +969,977 @@ void VirusCellModel::initialiseEpithelialCellAgent( int epithelialCellIndex, int
                             EpithelialCellAgent::NeighbouringCellModificationType::NoModification, repast::AgentId(-1, -1, -1, -1), 
                             extracellularVirusReleaseProb, cellToCellTransmissionProb,
                             releaseRate, countOfVirionsToRelease, virionReleaseRemainder);
+
+        // The copies of the cell in the buffer zones of the neighbours need the new cell, even if it ends the step in the state last sent
+        // for it (e.g. when it died and was divided into in the same step), so the state last sent is forgotten.
+        int localExtentY = discreteGridSpace->dimensions().extents().getY();
+        std::vector<int> cellLocation;
+        discreteGridSpace->getLocation(theExistingCellObject->getId(), cellLocation);
+        int x = cellLocation[0] - discreteGridSpace->dimensions().origin().getX();
+        int y = cellLocation[1] - discreteGridSpace->dimensions().origin().getY();
+        lastSentBoundaryCellStates[x * localExtentY + y] = -1;
+    }
+}
+
+
+
+/**********************
+*   VirusCellModel::initialiseVirionAgent - Creates a virion (virus particle) agent, sets all its parameters and places it on the grid.
+**********************/
+void VirusCellModel::initialiseVirionAgent(int virionIndex, bool isAReleasedVirus, int xCoor, int yCoor)
+{  
+    int rank = repast::RepastProcess::instance()->rank();
+
+    repast::AgentId newVirionId(virionIndex, rank, 1);
+    newVirionId.currentRank(rank);
+
+    // Assign an arbitrary lifespan to the virion
+    repast::NormalGenerator lifespanGenerator = repast::Random::instance()->createNormalGenerator(virionAvgLifespan, virionLifespanStdev);
+    int virionLifespan = lifespanGenerator.next();
+    while(virionLifespan < 1)
+    {
+        virionLifespan = lifespanGenerator.next();
+    }
+
+    // Assign an arbitrary age to the virion if it is from the starting population (simulation initialisation). If it is a released virus, then the age should be 0.
+    int virionAge = 0;
+    if( !isAReleasedVirus )
+    {
+        repast::IntUniformGenerator ageGenerator = repast::Random::instance()->createUniIntGenerator(0, virionLifespan);
+        virionAge = ageGenerator.next();
+    }
+
+    // Assign the target cell penetration probability to the virion
+    double virionPenetrationProb = virionPenetrationProbability;
+
+    // Assign the virion clearance probability (that is probability that a free virus particle is cleared off through unmodelled immune mechanisms)
+    double clearanceProb = virionClearanceProbability;
+
+    // The coefficient of increasing the clearance probability, for each immune cell which is at the current location.
+    // The more immune cells are present at that locaiton, the higher the probability that there are also 
+    // more unmodelled immune cell mechanisms carried out there, hence higher clearance probability.
+    double clearanceProbScaler = virionClearanceProbabilityScaler;
+
+    VirionAgent* newVirion = new VirionAgent(newVirionId, virionLifespan, virionAge, virionPenetrationProb, clearanceProb, clearanceProbScaler);
+    context.addAgent(newVirion);
+    PopulationCounters::instance()->mobileAgentAdded(1);
+
+    // Place the agent in the grid spatial projection. If it is a released virus then use the provided coordinates, to place it in the grid.
+    // That is since, the released virions are initialised at the position of the cell which has released them
+    if( isAReleasedVirus )
+    {
+        repast::Point<int> virionLocation(xCoor, yCoor);
+        discreteGridSpace->moveTo(newVirionId, virionLocation);
+    }
+    else
+    {
+        // If it is a virion agent from the starting population, then set its position stochastically.
+        // This will place the agent somewhere in the bounds of the part of the grid handled by this process/rank.
+        repast::IntUniformGenerator gridXCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getX() - 1);
+        int virionXCoor = discreteGridSpace->dimensions().origin().getX() + gridXCoorGenerator.next();
+
+        repast::IntUniformGenerator gridYCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getY() - 1);
+        int virionYCoor = discreteGridSpace->dimensions().origin().getY() + gridYCoorGenerator.next();
+
+        repast::Point<int> virionLocation(virionXCoor, virionYCoor);
+        discreteGridSpace->moveTo(newVirionId, virionLocation);
+    }
+
+}
+
+
+
+/**********************
+*   VirusCellModel::initialiseInnateImmuneCellAgent - Creates an innate immune cell agent, sets all its parameters and places it on the grid.
+**********************/
+void VirusCellModel::initialiseInnateImmuneCellAgent( int immuneCellId, bool isRecruitedCell )
+{
+    int rank = repast::RepastProcess::instance()->rank();
+
+    repast::AgentId newInnateImmuneCellId(immuneCellId, rank, 2);
+    newInnateImmuneCellId.currentRank(rank);
+
+    // Stochastically assign the lifepsan of the innate immune cell based on the provided lifespan parameters.
+    repast::NormalGenerator lifespanGenerator = repast::Random::instance()->createNormalGenerator(innateImmuneCellAvgLifespan, innateImmuneCellLifespanStdev);
+    int innateImmuneCellLifespan = lifespanGenerator.next();
+    while( innateImmuneCellLifespan < 1 )
+    {
+        innateImmuneCellLifespan = lifespanGenerator.next();
+    }
+  
+    // Assign an arbitrary age (between 0 and the lifespan) to the innate immune cell if it is from the starting population (simulation initialisation).
+    // If it is a newly recruited cell, then the age should be 0.
+    int cellAge = 0;
+    if( !isRecruitedCell )
+    {
+        repast::IntUniformGenerator ageGenerator = repast::Random::instance()->createUniIntGenerator(0, innateImmuneCellLifespan);
+        cellAge = ageGenerator.next();
+    }
+
+    // Set the probabilities for recognising and eliminating infected cells.
+    double infectedCellRecognitionProb = innateImmuneCellInfectedCellRecognitionProb;
+    double infectedCellEliminationProb = innateImmuneCellInfectedCellEliminationProb;
+
+    // Set the probability of an innate cell recruiting a specialised immune cell when infection is detected.
+    double specialisedImmuneCellRecruitProb = innateImmuneCellRecruitSpecImmuneCellProb;
+
+    // Create the agent.
+    InnateImmuneCellAgent* newInnateImmuneCell = new InnateImmuneCellAgent(newInnateImmuneCellId, innateImmuneCellLifespan, cellAge ,infectedCellRecognitionProb, 
+    infectedCellEliminationProb, specialisedImmuneCellRecruitProb, innateImmuneCellRecruitRateOfInnateCell, specialisedImmuneCellRecruitRateOfInnateCell);
+    context.addAgent(newInnateImmuneCell);
+    PopulationCounters::instance()->mobileAgentAdded(2);
+
+    // Place the agent in the grid spatial projection stochastically.
+    // This will place the agent somewhere in the bounds of the part of the grid handled by this process/rank.
+    repast::IntUniformGenerator gridXCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getX() - 1);
+    int innateImmuneCellX = discreteGridSpace->dimensions().origin().getX() + gridXCoorGenerator.next();
+
+    repast::IntUniformGenerator gridYCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getY() - 1);
+    int innateImmuneCellY = discreteGridSpace->dimensions().origin().getY() + gridYCoorGenerator.next();
+
+    repast::Point<int> immuneCellLoc(innateImmuneCellX, innateImmuneCellY);
+    discreteGridSpace->moveTo(newInnateImmuneCellId, immuneCellLoc);
+}
+
+
+
+/**********************
+*   VirusCellModel::initialiseSpecialisedImmuneCellAgent - Creates a specialised immune cell agent, sets all its parameters and places it on the grid.
+**********************/
+void VirusCellModel::initialiseSpecialisedImmuneCellAgent( int immuneCellId, bool isRecruitedCell )
+{
+    int rank = repast::RepastProcess::instance()->rank();
+
+    repast::AgentId newSpecialisedImmuneCellId(immuneCellId, rank, 3);
+    newSpecialisedImmuneCellId.currentRank(rank);
+
+    // Stochastically assign the lifepsan of the specialised immune cell based on the provided lifespan parameters.
+    repast::NormalGenerator lifespanGenerator = repast::Random::instance()->createNormalGenerator(specialisedImmuneCellAvgLifespan, specialisedImmuneCellLifespanStdev);
+    int specialisedImmuneCellLifespan = lifespanGenerator.next();
+    while( specialisedImmuneCellLifespan < 1 )
+    {
+        specialisedImmuneCellLifespan = lifespanGenerator.next();
+    }
+
+    // Assign an arbitrary age (between 0 and the lifespan) to the specialised immune cell if it is from the starting population (simulation initialisation).
+    // If it is a newly recruited cell, then the age should be 0.
+    int cellAge = 0;
+    if( !isRecruitedCell )
+    {
+        repast::IntUniformGenerator ageGenerator = repast::Random::instance()->createUniIntGenerator(0, specialisedImmuneCellLifespan);
+        ageGenerator.next();
+    }
+
+    // Set the probabilities for recognising and eliminating infected cells.
+    double infectedCellRecognitionProb = specialisedImmuneCellInfectedCellRecognitionProb;
+    double infectedCellEliminationProb = specialisedImmuneCellInfectedCellEliminationProb;
+
+    // Create the agent object.
+    SpecialisedImmuneCellAgent* newSpecialisedImmuneCell = new SpecialisedImmuneCellAgent(newSpecialisedImmuneCellId, specialisedImmuneCellLifespan, cellAge, infectedCellRecognitionProb, infectedCellEliminationProb, specialisedImmuneCellRecruitRateOfSpecCell);
+    context.addAgent(newSpecialisedImmuneCell);
+    PopulationCounters::instance()->mobileAgentAdded(3);
+
+    // Place the agent in the grid spatial projection stochastically. 
+    // This will place the agent somewhere in the bounds of the part of the grid handled by this process/rank.
+    repast::IntUniformGenerator gridXCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getX() - 1);
+    int specialisedImmuneCellX = discreteGridSpace->dimensions().origin().getX() + gridXCoorGenerator.next();
+
+    repast::IntUniformGenerator gridYCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getX() - 1);
+    int specialisedImmuneCellY = discreteGridSpace->dimensions().origin().getY() + gridYCoorGenerator.next();
+
+    repast::Point<int> immuneCellLoc(specialisedImmuneCellX, specialisedImmuneCellY);
+    discreteGridSpace->moveTo(newSpecialisedImmuneCellId, immuneCellLoc);
+}
+
+
+
+/**********************
+*   VirusCellModel::printEndOfTimestep - Prints a statement that a timestep has finished.
+**********************/
+void VirusCellModel::printEndOfTimestep(){
+    // Get the rank
+	int rank = repast::RepastProcess::instance()->rank();
+    // Print it only for one rank, as otherwise we'll get duplication of print statements.
+    if(rank == 0)
+    {
+        std::cout<<"Timestep: "<<(int)repast::RepastProcess::instance()->getScheduleRunner().currentTick()<<std::endl;
     }
 }
 
 
 
-/**********************
-*   VirusCellModel::initialiseVirionAgent - Creates a virion (virus particle) agent, sets all its parameters and places it on the grid.
-**********************/
-void VirusCellModel::initialiseVirionAgent(int virionIndex, bool isAReleasedVirus, int xCoor, int yCoor)
-{  
-    int rank = repast::RepastProcess::instance()->rank();
+/**********************
+*   VirusCellModel::writeSpatialSnapshot - Writes the state of each site of this process's section of the grid into the snapshot of the current tick:
+*   the states of its epithelial cell and the counts of the mobile agents on it. All processes write their sections into the same file.
+**********************/
+void VirusCellModel::writeSpatialSnapshot()
+{
+    int tick = (int)repast::RepastProcess::instance()->getScheduleRunner().currentTick();
+
+    int localOriginX = discreteGridSpace->dimensions().origin().getX();
+    int localOriginY = discreteGridSpace->dimensions().origin().getY();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
+    size_t localSitesCount = discreteGridSpace->dimensions().extents().getX() * localExtentY;
+
+    std::vector<unsigned char> epithelialCellStates(localSitesCount, 0);
+    std::vector<std::vector<unsigned char> > agentCounts(4, std::vector<unsigned char>(localSitesCount, 0));
+
+    std::vector<VirusCellInteractionAgents*> theLocalAgents;
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theLocalAgents, false);
+
+    std::vector<VirusCellInteractionAgents*>::iterator agentIter;
+    for( agentIter = theLocalAgents.begin(); agentIter != theLocalAgents.end(); ++agentIter )
+    {
+        std::vector<int> agentLocation;
+        discreteGridSpace->getLocation((*agentIter)->getId(), agentLocation);
+        size_t siteIndex = (agentLocation[0] - localOriginX) * localExtentY + (agentLocation[1] - localOriginY);
+
+        int agentType = (*agentIter)->getId().agentType();
+        if( agentType == 0 )
+        {
+            EpithelialCellAgent* theCell = static_cast<EpithelialCellAgent*>(*agentIter);
+            epithelialCellStates[siteIndex] = theCell->getInternalState() | (theCell->getExternalState() << 2);
+        }
+        else if( agentCounts[agentType][siteIndex] < 255 )
+        {
+            ++agentCounts[agentType][siteIndex];
+        }
+    }
+
+    snapshotWriter->write(outputDirectory + "/snapshot_" + std::to_string(tick) + ".bin", tick, epithelialCellStates, agentCounts[1], agentCounts[2], agentCounts[3]);
+}
+
+
+
+/**********************
+*   VirusCellModel::writeRasterFrame - Adds the local agents to the blocks of the raster pyramid and writes its frame for the current tick.
+**********************/
+void VirusCellModel::writeRasterFrame()
+{
+    int localOriginX = discreteGridSpace->dimensions().origin().getX();
+    int localOriginY = discreteGridSpace->dimensions().origin().getY();
+
+    rasterPyramid->clear();
+
+    std::vector<VirusCellInteractionAgents*> theLocalAgents;
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theLocalAgents, false);
+
+    std::vector<VirusCellInteractionAgents*>::iterator agentIter;
+    for( agentIter = theLocalAgents.begin(); agentIter != theLocalAgents.end(); ++agentIter )
+    {
+        std::vector<int> agentLocation;
+        discreteGridSpace->getLocation((*agentIter)->getId(), agentLocation);
+        int localX = agentLocation[0] - localOriginX;
+        int localY = agentLocation[1] - localOriginY;
+
+        int agentType = (*agentIter)->getId().agentType();
+        if( agentType == 0 )
+        {
+            int internalState = static_cast<EpithelialCellAgent*>(*agentIter)->getInternalState();
+            if( internalState == EpithelialCellAgent::InternalState::Infected )
+            {
+                rasterPyramid->addToSite(localX, localY, RasterPyramid::InfectedCellsChannel);
+            }
+            else if( internalState == EpithelialCellAgent::InternalState::Dead )
+            {
+                rasterPyramid->addToSite(localX, localY, RasterPyramid::DeadCellsChannel);
+            }
+        }
+        else if( agentType == 1 )
+        {
+            rasterPyramid->addToSite(localX, localY, RasterPyramid::VirionsChannel);
+        }
+        else
+        {
+            rasterPyramid->addToSite(localX, localY, RasterPyramid::ImmuneCellsChannel);
+        }
+    }
+
+    rasterPyramid->writeFrame((int)repast::RepastProcess::instance()->getScheduleRunner().currentTick());
+}
+
+
+
+/**********************
+*   VirusCellModel::analysePlaques - Marks the sites of this process's section holding an infected or a dead epithelial cell, and finds the plaques
+*   they form over the whole grid.
+**********************/
+void VirusCellModel::analysePlaques()
+{
+    int localOriginX = discreteGridSpace->dimensions().origin().getX();
+    int localOriginY = discreteGridSpace->dimensions().origin().getY();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
+    std::vector<unsigned char> isPlaqueSite(discreteGridSpace->dimensions().extents().getX() * localExtentY, 0);
+
+    std::vector<VirusCellInteractionAgents*> theEpithelialCells;
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theEpithelialCells, 0, false, -1);
+
+    std::vector<VirusCellInteractionAgents*>::iterator cellIter;
+    for( cellIter = theEpithelialCells.begin(); cellIter != theEpithelialCells.end(); ++cellIter )
+    {
+        int internalState = static_cast<EpithelialCellAgent*>(*cellIter)->getInternalState();
+        if( internalState == EpithelialCellAgent::InternalState::Infected || internalState == EpithelialCellAgent::InternalState::Dead )
+        {
+            std::vector<int> cellLocation;
+            discreteGridSpace->getLocation((*cellIter)->getId(), cellLocation);
+            isPlaqueSite[(cellLocation[0] - localOriginX) * localExtentY + (cellLocation[1] - localOriginY)] = 1;
+        }
+    }
+
+    plaqueAnalysis->analyse(isPlaqueSite);
+}
+
+
+
+/**********************
+*   VirusCellModel::trackInfectionFront - Adds the sites of this process's infected epithelial cells to the front tracker and completes its tick.
+**********************/
+void VirusCellModel::trackInfectionFront()
+{
+    frontTracker->clear();
+
+    std::vector<VirusCellInteractionAgents*> theEpithelialCells;
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theEpithelialCells, 0, false, -1);
+
+    std::vector<VirusCellInteractionAgents*>::iterator cellIter;
+    for( cellIter = theEpithelialCells.begin(); cellIter != theEpithelialCells.end(); ++cellIter )
+    {
+        if( static_cast<EpithelialCellAgent*>(*cellIter)->getInternalState() == EpithelialCellAgent::InternalState::Infected )
+        {
+            std::vector<int> cellLocation;
+            discreteGridSpace->getLocation((*cellIter)->getId(), cellLocation);
+            frontTracker->addInfectedSite(cellLocation[0] - originCoordinate, cellLocation[1] - originCoordinate);
+        }
+    }
+
+    frontTracker->completeTick((int)repast::RepastProcess::instance()->getScheduleRunner().currentTick());
+}
+
+
+
+/**********************
+*   VirusCellModel::writeCheckpoint - Writes the full state of the simulation after the current tick: the local agents of each process with their sites,
+*   the id trackers and step count of each process, and the state of its random number engine. The buffer zone copies are not written,
+*   as they are recreated from their originals by the first synchronisation after a restart.
+*   No checkpoint is written if the state of the engine of any process does not fit in the checkpoint, as a truncated state could not be restored.
+**********************/
+void VirusCellModel::writeCheckpoint()
+{
+    int rank = repast::RepastProcess::instance()->rank();
+    int tick = (int)repast::RepastProcess::instance()->getScheduleRunner().currentTick();
+
+    CheckpointProcessState processState;
+    std::memset(&processState, 0, sizeof(processState));
+    processState.currVirionAgentId = currVirionAgentId;
+    processState.currInnateImmuneCellAgentId = currInnateImmuneCellAgendId;
+    processState.currSpecialisedImmuneCellAgentId = currSpecialisedImmuneCellAgentId;
+    processState.executedStepsCount = executedStepsCount;
+    processState.countVirsWhichManagedToInfectACell = countVirsWhichManagedToInfectACell;
+
+    std::ostringstream randomEngineState;
+    randomEngineState<<repast::Random::instance()->engine();
+    int isRandomStateFitting = (randomEngineState.str().size() < static_cast<size_t>(checkpointRandomStateBytes)) ? 1 : 0;
+    int isEveryRandomStateFitting = 0;
+    MPI_Allreduce(&isRandomStateFitting, &isEveryRandomStateFitting, 1, MPI_INT, MPI_LAND, processNeighbourhood->getCartesianCommunicator());
+    if( !isEveryRandomStateFitting )
+    {
+        if( !isRandomStateFitting )
+        {
+            std::cout<<"RANK "<<rank<<" cannot write the checkpoint at tick "<<tick<<", as the state of its random number engine takes "
+                <<randomEngineState.str().size()<<" bytes, while the checkpoint holds at most "<<checkpointRandomStateBytes - 1<<"!"<<std::endl;
+        }
+        return;
+    }
+    std::strncpy(processState.randomEngineState, randomEngineState.str().c_str(), checkpointRandomStateBytes - 1);
+
+    std::vector<VirusCellInteractionAgents*> theLocalAgents;
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theLocalAgents, false);
+
+    std::vector<CheckpointAgentRecord> agentRecords(theLocalAgents.size());
+    std::vector<VirusCellInteractionAgentPackage> agentPackages;
+    agentPackages.reserve(theLocalAgents.size());
+    for( size_t i = 0; i < theLocalAgents.size(); ++i )
+    {
+        agentProvider->providePackage(theLocalAgents[i], agentPackages);
+
+        std::vector<int> agentLocation;
+        discreteGridSpace->getLocation(theLocalAgents[i]->getId(), agentLocation);
+        agentRecords[i].x = agentLocation[0] - originCoordinate;
+        agentRecords[i].y = agentLocation[1] - originCoordinate;
+        agentRecords[i].package = agentPackages[i];
+    }
+
+    checkpoint->write(outputDirectory + "/checkpoint.bin", tick, getParametersText(), processState, agentRecords);
+}
+
+
+
+/**********************
+*   VirusCellModel::restoreFromCheckpoint - Recreates the agents of this process's section of the grid from a checkpoint and restores the state
+*   of the process. The agents are created through the package receiver, as if they had migrated to this process, so they are counted as local.
+*   The agents are added to the context in a different order than they were in before the checkpoint, so the continued simulation is
+*   a valid continuation from the checkpointed state, but not the exact same sequence of events as an uninterrupted run.
+*   A fork reseeds the random number engine with the seed of this run instead of restoring it, and applies the changed parameters to the agents.
+*   A process whose rank did not exist in the checkpointed run has no engine state to restore, so it reseeds its engine from the seed and its rank.
+*   The epithelial cells are given the ids of their sites in the section of this process, as the section may differ from the checkpointed one,
+*   and the boundary exchange relies on the ids of the epithelial cells being unique per process.
+**********************/
+bool VirusCellModel::restoreFromCheckpoint(std::string fileName, bool isFork)
+{
+    int rank = repast::RepastProcess::instance()->rank();
+    int localOriginX = discreteGridSpace->dimensions().origin().getX();
+    int localOriginY = discreteGridSpace->dimensions().origin().getY();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
+
+    int checkpointTick;
+    std::string checkpointParametersText;
+    CheckpointProcessState processState;
+    std::vector<CheckpointAgentRecord> agentRecords;
+    if( !checkpoint->read(fileName, checkpointTick, checkpointParametersText, processState, agentRecords) )
+    {
+        return false;
+    }
+
+    currVirionAgentId = processState.currVirionAgentId;
+    currInnateImmuneCellAgendId = processState.currInnateImmuneCellAgentId;
+    currSpecialisedImmuneCellAgentId = processState.currSpecialisedImmuneCellAgentId;
+    executedStepsCount = processState.executedStepsCount;
+    countVirsWhichManagedToInfectACell = processState.countVirsWhichManagedToInfectACell;
+
+    if( isFork )
+    {
+        repast::Random::instance()->engine().seed(repast::Random::instance()->seed());
+        applyForkedParameters(checkpointParametersText, agentRecords);
+    }
+    else if( processState.randomEngineState[0] == '\0' )
+    {
+        repast::Random::instance()->engine().seed(static_cast<uint32_t>(repast::Random::instance()->seed()) + 0x9E3779B9u * static_cast<uint32_t>(rank + 1));
+    }
+    else
+    {
+        processState.randomEngineState[checkpointRandomStateBytes - 1] = '\0';
+        std::istringstream randomEngineState(processState.randomEngineState);
+        randomEngineState>>repast::Random::instance()->engine();
+    }
+
+    agentReceiver->setReceivingMigratingAgents(true);
+    for( size_t i = 0; i < agentRecords.size(); ++i )
+    {
+        agentRecords[i].package.currentRank = rank;
+        if( agentRecords[i].package.type == 0 )
+        {
+            int localX = agentRecords[i].x + originCoordinate - localOriginX;
+            int localY = agentRecords[i].y + originCoordinate - localOriginY;
+            agentRecords[i].package.id = localX * localExtentY + localY;
+            agentRecords[i].package.rank = rank;
+        }
+        VirusCellInteractionAgents* theAgent = agentReceiver->createAgent(agentRecords[i].package);
+        context.addAgent(theAgent);
+
+        repast::Point<int> agentLocation(agentRecords[i].x + originCoordinate, agentRecords[i].y + originCoordinate);
+        discreteGridSpace->moveTo(theAgent->getId(), agentLocation);
+    }
+    agentReceiver->setReceivingMigratingAgents(false);
+
+    startTick = checkpointTick;
+    if( rank == 0 )
+    {
+        std::cout<<(isFork ? "Forked" : "Restarted")<<" from the checkpoint "<<fileName<<" at tick "<<startTick<<"."<<std::endl;
+    }
+
+    return true;
+}
+
+
+
+/**********************
+*   VirusCellModel::applyForkedParameters - Applies the parameters of this run which differ from the ones of the checkpointed run to the restored agents.
+*   The agents take most of their parameters straight from the properties, and those are overwritten with the new values. The virion release rate
+*   of each epithelial cell is drawn from a distribution, so it is drawn again from the new one if its average or deviation has changed.
+*   The other drawn parameters (lifespans, delays, division rates) only apply to the agents created from now on, as drawing them again
+*   would not keep the ages and timers the agents have already reached consistent.
+**********************/
+void VirusCellModel::applyForkedParameters(const std::string& checkpointParametersText, std::vector<CheckpointAgentRecord>& agentRecords)
+{
+    std::map<std::string, std::string> checkpointParameters;
+    std::stringstream parametersStream(checkpointParametersText);
+    std::string parameterLine;
+    while( std::getline(parametersStream, parameterLine) )
+    {
+        size_t separator = parameterLine.find('=');
+        if( separator != std::string::npos )
+        {
+            checkpointParameters[parameterLine.substr(0, separator)] = parameterLine.substr(separator + 1);
+        }
+    }
+
+    // The parameters each agent type takes straight from the properties, with the package variable holding them.
+    struct AgentParameter
+    {
+        const char* propertyName;
+        int agentType;
+        double VirusCellInteractionAgentPackage::* packageVariable;
+        double value;
+    };
+    const AgentParameter agentParameters[] = {
+        { "release.virus.in.extracellular.space.probability", 0, &VirusCellInteractionAgentPackage::extracellularReleaseProb, extracellularVirusReleaseProb },
+        { "cell.to.cell.transmission.probability", 0, &VirusCellInteractionAgentPackage::cellToCellTransmissionProb, cellToCellTransmissionProb },
+        { "virion.cell.penetration.probability", 1, &VirusCellInteractionAgentPackage::penetrationProbability, virionPenetrationProbability },
+        { "virion.clearance.probability", 1, &VirusCellInteractionAgentPackage::clearanceProbability, virionClearanceProbability },
+        { "virion.clearance.scaler", 1, &VirusCellInteractionAgentPackage::clearanceProbScaler, virionClearanceProbabilityScaler },
+        { "innate.immune.cell.infected.cell.recognition.probability", 2, &VirusCellInteractionAgentPackage::infectedCellRecognitionProb, innateImmuneCellInfectedCellRecognitionProb },
+        { "innate.immune.cell.infected.cell.elimination.probability", 2, &VirusCellInteractionAgentPackage::infectedCellEliminationProb, innateImmuneCellInfectedCellEliminationProb },
+        { "innate.immune.cell.recruit.specialised.immune.cell.probability", 2, &VirusCellInteractionAgentPackage::specialisedImmuneCellRecruitProb, innateImmuneCellRecruitSpecImmuneCellProb },
+        { "innate.immune.cell.recruit.rate.of.innate.cell", 2, &VirusCellInteractionAgentPackage::innateImmuneCellRecruitRate, innateImmuneCellRecruitRateOfInnateCell },
+        { "specialised.immune.cell.recruit.rate.of.innate.cell", 2, &VirusCellInteractionAgentPackage::specialisedImmuneCellRecruitRate, specialisedImmuneCellRecruitRateOfInnateCell },
+        { "specialised.immune.cell.infected.cell.recognition.probability", 3, &VirusCellInteractionAgentPackage::infectedCellRecognitionProb, specialisedImmuneCellInfectedCellRecognitionProb },
+        { "specialised.immune.cell.infected.cell.elimination.probability", 3, &VirusCellInteractionAgentPackage::infectedCellEliminationProb, specialisedImmuneCellInfectedCellEliminationProb },
+        { "specialised.immune.cell.recruit.rate.of.specialised.cell", 3, &VirusCellInteractionAgentPackage::specialisedImmuneCellRecruitRate, specialisedImmuneCellRecruitRateOfSpecCell }
+    };
+
+    for( size_t p = 0; p < sizeof(agentParameters) / sizeof(agentParameters[0]); ++p )
+    {
+        const AgentParameter& parameter = agentParameters[p];
+        if( repast::strToDouble(checkpointParameters[parameter.propertyName]) == parameter.value )
+        {
+            continue;
+        }
+
+        for( size_t i = 0; i < agentRecords.size(); ++i )
+        {
+            if( agentRecords[i].package.type == parameter.agentType )
+            {
+                agentRecords[i].package.*(parameter.packageVariable) = parameter.value;
+            }
+        }
+    }
+
+    if( repast::strToDouble(checkpointParameters["epithelial.cell.infected.virion.release.rate.average"]) != epithCellVirionReleaseRateAvg
+        || repast::strToDouble(checkpointParameters["epithelial.cell.infected.virion.release.rate.standard.dev"]) != epithCellVirionReleaseRateStdev )
+    {
+        repast::NormalGenerator virionReleaseRateGen = repast::Random::instance()->createNormalGenerator(epithCellVirionReleaseRateAvg, epithCellVirionReleaseRateStdev);
+        for( size_t i = 0; i < agentRecords.size(); ++i )
+        {
+            if( agentRecords[i].package.type == 0 )
+            {
+                double releaseRate = virionReleaseRateGen.next();
+                while( releaseRate < 0.1 )
+                {
+                    releaseRate = virionReleaseRateGen.next();
+                }
+                agentRecords[i].package.virionReleaseRate = releaseRate;
+            }
+        }
+    }
+}
+
+
+
+/**********************
+*   VirusCellModel::executeTimestep - Function which will execute the timestep. It will trigger all agents to act on each timestep.
+*   The step is pipelined: the epithelial cells on the boundary of this process's section of the grid act first, as only they can request
+*   modifications of cells on neighbouring processes. Their requests are sent without blocking, and the remaining agents act while the
+*   requests are in flight. The step only waits for the requests of the neighbouring processes before carrying them out.
+**********************/
+void VirusCellModel::executeTimestep()
+{
+    double timestepStart = MPI_Wtime();
+    ++executedStepsCount;
+
+    std::vector<VirusCellInteractionAgents*>::iterator iter;
+
+    std::vector<VirusCellInteractionAgents*> theLocalAgents;
+    // Get the local agents and make them perform a step. This will include all agents: Epithelial cells, Virions, Specialised and Non-Specialised immune cells.
+    // They will also be in random order which will provide the stochasticity we need, as there is no way to make them act synchronously.
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theLocalAgents);
+
+    // Split the agents into the boundary epithelial cells and the rest, keeping the random order within each of the two groups.
+    std::vector<VirusCellInteractionAgents*> theBoundaryAgents;
+    std::vector<VirusCellInteractionAgents*> theInteriorAgents;
+    theInteriorAgents.reserve(theLocalAgents.size());
+    for( iter = theLocalAgents.begin(); iter != theLocalAgents.end(); ++iter )
+    {
+        if( boundaryEpithelialCellSet.count(*iter) != 0 )
+        {
+            theBoundaryAgents.push_back(*iter);
+        }
+        else
+        {
+            theInteriorAgents.push_back(*iter);
+        }
+    }
+
+    for( iter = theBoundaryAgents.begin(); iter != theBoundaryAgents.end(); ++iter )
+    {
+        stepLocalAgent(*iter);
+    }
+
+    // All requests for cells on the neighbouring processes are known now, so send them while the rest of the agents act.
+    double exchangePosted = MPI_Wtime();
+    processNeighbourhood->beginExchange(outgoingModificationRequests, maxModificationRequestsPerNeighbour);
+    for( size_t i = 0; i < outgoingModificationRequests.size(); ++i )
+    {
+        outgoingModificationRequests[i].clear();
+    }
+
+    // Check on the exchange every now and then, which both lets MPI progress it and tells us when it has completed.
+    double exchangeCompleted = -1.0;
+    int stepsSinceExchangeCheck = 0;
+    for( iter = theInteriorAgents.begin(); iter != theInteriorAgents.end(); ++iter )
+    {
+        stepLocalAgent(*iter);
+
+        if( exchangeCompleted < 0 && ++stepsSinceExchangeCheck == 64 )
+        {
+            stepsSinceExchangeCheck = 0;
+            if( processNeighbourhood->testExchange() )
+            {
+                exchangeCompleted = MPI_Wtime();
+            }
+        }
+    }
+    double interiorStepEnd = MPI_Wtime();
 
-    repast::AgentId newVirionId(virionIndex, rank, 1);
-    newVirionId.currentRank(rank);
+    // Carry out the division/infection requests the neighbouring processes have sent for cells local to this process.
+    // This is the only way to propagate changes to the original agents, as modifying the copies in the buffer zone would not reach the originals.
+    processNeighbourhood->completeExchange(incomingModificationRequests);
+    double exchangeWaitEnd = MPI_Wtime();
+    if( exchangeCompleted < 0 )
+    {
+        exchangeCompleted = exchangeWaitEnd;
+    }
 
-    // Assign an arbitrary lifespan to the virion
-    repast::NormalGenerator lifespanGenerator = repast::Random::instance()->createNormalGenerator(virionAvgLifespan, virionLifespanStdev);
-    int virionLifespan = lifespanGenerator.next();
-    while(virionLifespan < 1)
+    applyNeighbouringCellModificationRequests();
+
+    // The buffer zone copies are only synchronised with their originals every haloExchangeInterval steps. On the other steps, advance the
+    // existing copies locally and overwrite the ones whose originals have changed in a way the copies could not follow, all in one message per neighbour.
+    // This is done before the projection synchronisation below adds any new copies (which already have the state after this step).
+    bool isHaloExchangeStep = (executedStepsCount % haloExchangeInterval == 0);
+    bool hasHaloUpdates = collectBoundaryEpithelialCellUpdates(isHaloExchangeStep);
+
+    // Find out whether any process needs the migration and projection synchronisations on this step, and whether any has halo updates to send.
+    // Repast's synchronisations and the exchange of the updates are collective, so all processes must agree on them, which takes a single reduction
+    // of two flags. It is overlapped with advancing the buffer zone copies, and the exchange of the updates is skipped when no process has any.
+    const int synchroniseAgentsFlag = 1;
+    const int exchangeHaloUpdatesFlag = 2;
+    int stepFlags = ((!canSkipUnneededSynchronisation || !hasSynchronisedProjection || hasAgentLeftLocalSection) ? synchroniseAgentsFlag : 0)
+                    | (hasHaloUpdates ? exchangeHaloUpdatesFlag : 0);
+    int anyStepFlags = synchroniseAgentsFlag;
+    MPI_Request stepFlagsRequest;
+    MPI_Iallreduce(&stepFlags, &anyStepFlags, 1, MPI_INT, MPI_BOR, processNeighbourhood->getCartesianCommunicator(), &stepFlagsRequest);
+
+    if( !isHaloExchangeStep )
     {
-        virionLifespan = lifespanGenerator.next();
+        advanceBufferZoneEpithelialCells();
     }
 
-    // Assign an arbitrary age to the virion if it is from the starting population (simulation initialisation). If it is a released virus, then the age should be 0.
-    int virionAge = 0;
-    if( !isAReleasedVirus )
+    MPI_Wait(&stepFlagsRequest, MPI_STATUS_IGNORE);
+    if( anyStepFlags & exchangeHaloUpdatesFlag )
     {
-        repast::IntUniformGenerator ageGenerator = repast::Random::instance()->createUniIntGenerator(0, virionLifespan);
-        virionAge = ageGenerator.next();
+        exchangeBoundaryEpithelialCellUpdates();
     }
 
-    // Assign the target cell penetration probability to the virion
-    double virionPenetrationProb = virionPenetrationProbability;
+    if( anyStepFlags & synchroniseAgentsFlag )
+    {
+        // Balancing the grid will identify the agents which have crossed the boundaries of their rank and need to be moved. 
+        discreteGridSpace->balance();
 
-    // Assign the virion clearance probability (that is probability that a free virus particle is cleared off through unmodelled immune mechanisms)
-    double clearanceProb = virionClearanceProbability;
+        // Synchronising the agent status will move the agents to the correct process.
+        // The receiver counts the agents moved to this process, the ones moved off it have been discounted as they left its section.
+        agentReceiver->setReceivingMigratingAgents(true);
+        repast::RepastProcess::instance()->synchronizeAgentStatus<VirusCellInteractionAgents, VirusCellInteractionAgentPackage, VirusCellInteractionAgentsPackageProvider, 
+            VirusCellInteractionAgentsPackageReceiver>(context, *agentProvider, *agentReceiver, *agentReceiver);
+        agentReceiver->setReceivingMigratingAgents(false);
 
-    // The coefficient of increasing the clearance probability, for each immune cell which is at the current location.
-    // The more immune cells are present at that locaiton, the higher the probability that there are also 
-    // more unmodelled immune cell mechanisms carried out there, hence higher clearance probability.
-    double clearanceProbScaler = virionClearanceProbabilityScaler;
+        // Synchronise the data about the section of the whole grid handled by each process. 
+        repast::RepastProcess::instance()->synchronizeProjectionInfo<VirusCellInteractionAgents, VirusCellInteractionAgentPackage, VirusCellInteractionAgentsPackageProvider, 
+            VirusCellInteractionAgentsPackageReceiver>(context, *agentProvider, *agentReceiver, *agentReceiver);
 
-    VirionAgent* newVirion = new VirionAgent(newVirionId, virionLifespan, virionAge, virionPenetrationProb, clearanceProb, clearanceProbScaler);
-    context.addAgent(newVirion);
+        hasSynchronisedProjection = true;
+    }
+    hasAgentLeftLocalSection = false;
 
-    // Place the agent in the grid spatial projection. If it is a released virus then use the provided coordinates, to place it in the grid.
-    // That is since, the released virions are initialised at the position of the cell which has released them
-    if( isAReleasedVirus )
+    // Synchronise all agents which are non-local to this process (The copies of non-local agents which this process owns).
+    // Ensures the buffer zone agents are most up-to-date copies of their original agents.
+    if( isHaloExchangeStep )
     {
-        repast::Point<int> virionLocation(xCoor, yCoor);
-        discreteGridSpace->moveTo(newVirionId, virionLocation);
+        repast::RepastProcess::instance()->synchronizeAgentStates<VirusCellInteractionAgentPackage, VirusCellInteractionAgentsPackageProvider, 
+            VirusCellInteractionAgentsPackageReceiver>(*agentProvider, *agentReceiver);
     }
-    else
+
+    double timestepEnd = MPI_Wtime();
+    accumulatedStepTime += timestepEnd - timestepStart;
+    accumulatedSynchronisationTime += timestepEnd - exchangeWaitEnd;
+
+    // Record the timing of the step. The communication hidden behind the interior step is the part of the exchange which completed
+    // while the interior agents were acting. The exposed part is the time spent waiting for the exchange after they had finished.
+    if( recordTimestepTiming && repast::RepastProcess::instance()->rank() == 0 )
     {
-        // If it is a virion agent from the starting population, then set its position stochastically.
-        // This will place the agent somewhere in the bounds of the part of the grid handled by this process/rank.
-        repast::IntUniformGenerator gridXCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getX() - 1);
-        int virionXCoor = discreteGridSpace->dimensions().origin().getX() + gridXCoorGenerator.next();
+        double hiddenCommunication = std::min(exchangeCompleted, interiorStepEnd) - exchangePosted;
+        double exposedWait = exchangeWaitEnd - interiorStepEnd;
+        double hiddenFraction = (hiddenCommunication + exposedWait > 0) ? hiddenCommunication / (hiddenCommunication + exposedWait) : 1.0;
 
-        repast::IntUniformGenerator gridYCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getY() - 1);
-        int virionYCoor = discreteGridSpace->dimensions().origin().getY() + gridYCoorGenerator.next();
+        timestepTimingOutput<<(int)repast::RepastProcess::instance()->getScheduleRunner().currentTick()<<","
+            <<exchangePosted - timestepStart<<","<<interiorStepEnd - exchangePosted<<","<<exposedWait<<","
+            <<hiddenCommunication<<","<<hiddenFraction<<","<<timestepEnd - exchangeWaitEnd<<","<<timestepEnd - timestepStart<<std::endl;
+    }
+}
 
-        repast::Point<int> virionLocation(virionXCoor, virionYCoor);
-        discreteGridSpace->moveTo(newVirionId, virionLocation);
+
+
+/**********************
+*   VirusCellModel::runCalibrationSteps - Executes the passed count of timesteps straight away, without the schedule or the data collection.
+*   Used to time the model on a particular process grid. Returns the time the slowest process has spent in the steps, and in the synchronisation part of them.
+**********************/
+void VirusCellModel::runCalibrationSteps(int stepsCount, double& stepTime, double& synchronisationTime)
+{
+    accumulatedStepTime = 0.0;
+    accumulatedSynchronisationTime = 0.0;
+
+    for( int i = 0; i < stepsCount; ++i )
+    {
+        executeTimestep();
     }
 
+    MPI_Comm comm = processNeighbourhood->getCartesianCommunicator();
+    MPI_Allreduce(&accumulatedStepTime, &stepTime, 1, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(&accumulatedSynchronisationTime, &synchronisationTime, 1, MPI_DOUBLE, MPI_MAX, comm);
 }
 
 
 
 /**********************
-*   VirusCellModel::initialiseInnateImmuneCellAgent - Creates an innate immune cell agent, sets all its parameters and places it on the grid.
+*   VirusCellModel::stepLocalAgent - Makes a local agent perform its step and handles the changes to the environment it has requested.
 **********************/
-void VirusCellModel::initialiseInnateImmuneCellAgent( int immuneCellId, bool isRecruitedCell )
+void VirusCellModel::stepLocalAgent(VirusCellInteractionAgents* theAgent)
 {
-    int rank = repast::RepastProcess::instance()->rank();
+    theAgent->doStep(&context, discreteGridSpace);
 
-    repast::AgentId newInnateImmuneCellId(immuneCellId, rank, 2);
-    newInnateImmuneCellId.currentRank(rank);
+    // Note if a mobile agent has moved out of this process's section of the grid, as it will then need to migrate to another process.
+    bool isOutsideLocalSection = false;
+    if( theAgent->getId().agentType() != 0 )
+    {
+        std::vector<int> agentLocation;
+        discreteGridSpace->getLocation(theAgent->getId(), agentLocation);
+        isOutsideLocalSection = !discreteGridSpace->dimensions().contains(agentLocation);
+        if( isOutsideLocalSection )
+        {
+            hasAgentLeftLocalSection = true;
+        }
+    }
 
-    // Stochastically assign the lifepsan of the innate immune cell based on the provided lifespan parameters.
-    repast::NormalGenerator lifespanGenerator = repast::Random::instance()->createNormalGenerator(innateImmuneCellAvgLifespan, innateImmuneCellLifespanStdev);
-    int innateImmuneCellLifespan = lifespanGenerator.next();
-    while( innateImmuneCellLifespan < 1 )
+    // For each specific type of agent we need if they have requested any change to the environment, which is only handled by the Virus_Cell_Model clas.
+    if( theAgent->getId().agentType() == 0 )
     {
-        innateImmuneCellLifespan = lifespanGenerator.next();
+        // Check if the cell has requested division, viral release or infection of a neighbouring cell.
+        checkForCellDivision(theAgent);
+        checkForCellVirionRelease(theAgent);
+        checkForCellToCellInfection(theAgent);
     }
-  
-    // Assign an arbitrary age (between 0 and the lifespan) to the innate immune cell if it is from the starting population (simulation initialisation).
-    // If it is a newly recruited cell, then the age should be 0.
-    int cellAge = 0;
-    if( !isRecruitedCell )
+    else if( theAgent->getId().agentType() == 2 )
     {
-        repast::IntUniformGenerator ageGenerator = repast::Random::instance()->createUniIntGenerator(0, innateImmuneCellLifespan);
-        cellAge = ageGenerator.next();
+        // Check if the innate immune cell has requested recruitment of other immune cells.
+        checkForInnateImmuneCellRecruitment(theAgent);
+        checkForSpecialisedImmuneCellRecruitement(theAgent);
+    }
+    else if( theAgent->getId().agentType() == 3 )
+    {
+        // Check if the specialised immune cell has requested recruitment of other specialised immune cells.
+        checkForSpecialisedImmuneCellRecruitement(theAgent);
     }
 
-    // Set the probabilities for recognising and eliminating infected cells.
-    double infectedCellRecognitionProb = innateImmuneCellInfectedCellRecognitionProb;
-    double infectedCellEliminationProb = innateImmuneCellInfectedCellEliminationProb;
-
-    // Set the probability of an innate cell recruiting a specialised immune cell when infection is detected.
-    double specialisedImmuneCellRecruitProb = innateImmuneCellRecruitSpecImmuneCellProb;
+    // Check if the agent has died during the timestep and remove it from the simulation. 
+    // Otherwise, if it has left this process's section, it is moved to the process owning its new location at the synchronisation of this step.
+    if( theAgent->getId().agentType() != 0 )
+    {
+        int agentType = theAgent->getId().agentType();
+        if( !removeLocalAgentIfDead(theAgent) && isOutsideLocalSection )
+        {
+            PopulationCounters::instance()->mobileAgentRemoved(agentType);
+        }
+    }
+}
 
-    // Create the agent.
-    InnateImmuneCellAgent* newInnateImmuneCell = new InnateImmuneCellAgent(newInnateImmuneCellId, innateImmuneCellLifespan, cellAge ,infectedCellRecognitionProb, 
-    infectedCellEliminationProb, specialisedImmuneCellRecruitProb, innateImmuneCellRecruitRateOfInnateCell, specialisedImmuneCellRecruitRateOfInnateCell);
-    context.addAgent(newInnateImmuneCell);
 
-    // Place the agent in the grid spatial projection stochastically.
-    // This will place the agent somewhere in the bounds of the part of the grid handled by this process/rank.
-    repast::IntUniformGenerator gridXCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getX() - 1);
-    int innateImmuneCellX = discreteGridSpace->dimensions().origin().getX() + gridXCoorGenerator.next();
 
-    repast::IntUniformGenerator gridYCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getY() - 1);
-    int innateImmuneCellY = discreteGridSpace->dimensions().origin().getY() + gridYCoorGenerator.next();
+/**********************
+*   VirusCellModel::advanceBufferZoneEpithelialCells - Advances the copies of the epithelial cells in the buffer zone by one step,
+*   on the steps when they are not synchronised with their originals. Only the epithelial cells are read across the process boundaries,
+*   so the copies of the other agent types are left as they are.
+**********************/
+void VirusCellModel::advanceBufferZoneEpithelialCells()
+{
+    std::vector<VirusCellInteractionAgents*> theBufferZoneEpithelialCells;
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::NON_LOCAL, theBufferZoneEpithelialCells, 0, false);
 
-    repast::Point<int> immuneCellLoc(innateImmuneCellX, innateImmuneCellY);
-    discreteGridSpace->moveTo(newInnateImmuneCellId, immuneCellLoc);
+    std::vector<VirusCellInteractionAgents*>::iterator iter;
+    for( iter = theBufferZoneEpithelialCells.begin(); iter != theBufferZoneEpithelialCells.end(); ++iter )
+    {
+        static_cast<EpithelialCellAgent*>(*iter)->advanceBufferZoneCopy();
+    }
 }
 
 
 
 /**********************
-*   VirusCellModel::initialiseSpecialisedImmuneCellAgent - Creates a specialised immune cell agent, sets all its parameters and places it on the grid.
+*   VirusCellModel::collectBoundaryEpithelialCellUpdates - Queues the updates of the boundary epithelial cells whose state has changed since it was
+*   last sent (or which have been divided into since), for the neighbouring processes holding copies of them. Returns whether any update was queued.
+*   Only the changes of the internal or external state are sent: everything else the copies work out by advancing themselves.
+*   On the steps when Repast synchronises the copies, only the states of the cells are recorded, as the ones the copies will have after it.
 **********************/
-void VirusCellModel::initialiseSpecialisedImmuneCellAgent( int immuneCellId, bool isRecruitedCell )
+bool VirusCellModel::collectBoundaryEpithelialCellUpdates(bool areCopiesSynchronisedByRepast)
 {
-    int rank = repast::RepastProcess::instance()->rank();
-
-    repast::AgentId newSpecialisedImmuneCellId(immuneCellId, rank, 3);
-    newSpecialisedImmuneCellId.currentRank(rank);
+    bool hasUpdates = false;
 
-    // Stochastically assign the lifepsan of the specialised immune cell based on the provided lifespan parameters.
-    repast::NormalGenerator lifespanGenerator = repast::Random::instance()->createNormalGenerator(specialisedImmuneCellAvgLifespan, specialisedImmuneCellLifespanStdev);
-    int specialisedImmuneCellLifespan = lifespanGenerator.next();
-    while( specialisedImmuneCellLifespan < 1 )
-    {
-        specialisedImmuneCellLifespan = lifespanGenerator.next();
-    }
+    int localExtentX = discreteGridSpace->dimensions().extents().getX();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
 
-    // Assign an arbitrary age (between 0 and the lifespan) to the specialised immune cell if it is from the starting population (simulation initialisation).
-    // If it is a newly recruited cell, then the age should be 0.
-    int cellAge = 0;
-    if( !isRecruitedCell )
+    std::vector<BoundaryEpithelialCell>::iterator boundaryIter;
+    for( boundaryIter = boundaryEpithelialCells.begin(); boundaryIter != boundaryEpithelialCells.end(); ++boundaryIter )
     {
-        repast::IntUniformGenerator ageGenerator = repast::Random::instance()->createUniIntGenerator(0, specialisedImmuneCellLifespan);
-        ageGenerator.next();
-    }
-
-    // Set the probabilities for recognising and eliminating infected cells.
-    double infectedCellRecognitionProb = specialisedImmuneCellInfectedCellRecognitionProb;
-    double infectedCellEliminationProb = specialisedImmuneCellInfectedCellEliminationProb;
-
-    // Create the agent object.
-    SpecialisedImmuneCellAgent* newSpecialisedImmuneCell = new SpecialisedImmuneCellAgent(newSpecialisedImmuneCellId, specialisedImmuneCellLifespan, cellAge, infectedCellRecognitionProb, infectedCellEliminationProb, specialisedImmuneCellRecruitRateOfSpecCell);
-    context.addAgent(newSpecialisedImmuneCell);
+        EpithelialCellAgent* theCell = boundaryIter->cell;
+        int x = boundaryIter->x;
+        int y = boundaryIter->y;
+        int cellIndex = x * localExtentY + y;
+        int cellState = theCell->getInternalState() * 4 + theCell->getExternalState();
+        if( cellState == lastSentBoundaryCellStates[cellIndex] )
+        {
+            continue;
+        }
+        lastSentBoundaryCellStates[cellIndex] = cellState;
 
-    // Place the agent in the grid spatial projection stochastically. 
-    // This will place the agent somewhere in the bounds of the part of the grid handled by this process/rank.
-    repast::IntUniformGenerator gridXCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getX() - 1);
-    int specialisedImmuneCellX = discreteGridSpace->dimensions().origin().getX() + gridXCoorGenerator.next();
+        if( areCopiesSynchronisedByRepast )
+        {
+            continue;
+        }
 
-    repast::IntUniformGenerator gridYCoorGenerator = repast::Random::instance()->createUniIntGenerator(0, discreteGridSpace->dimensions().extents().getX() - 1);
-    int specialisedImmuneCellY = discreteGridSpace->dimensions().origin().getY() + gridYCoorGenerator.next();
+        EpithelialCellHaloUpdate update;
+        update.cellId = theCell->getId().id();
+        update.cellStartRank = theCell->getId().startingRank();
+        update.lifespan = theCell->getLifespan();
+        update.age = theCell->getAge();
+        update.internalState = theCell->getInternalState();
+        update.externalState = theCell->getExternalState();
+        update.infectedLifespan = theCell->getInfectedLifespan();
+        update.timeInfected = theCell->getTimeInfected();
+        update.divisionRate = theCell->getDivisionRate();
+        update.timeSinceLastDivision = theCell->getTimeSinceLastDivision();
+        update.releaseDelay = theCell->getReleaseDelay();
+        update.displayVirProteinsDelay = theCell->getDisplayVirProteinsDelay();
+        update.extracellularReleaseProb = theCell->getExtracellularReleaseProb();
+        update.cellToCellTransmissionProb = theCell->getCellToCellTransmissionProb();
+        update.virionReleaseRate = theCell->getVirionReleaseRate();
+        update.virionReleaseRemainder = theCell->getVirionReleaseRemainder();
+
+        // The cell is in the buffer zone of the neighbours in the directions of the edges of the section it lies on.
+        int minDx = (x == 0) ? -1 : 0;
+        int maxDx = (x == localExtentX - 1) ? 1 : 0;
+        int minDy = (y == 0) ? -1 : 0;
+        int maxDy = (y == localExtentY - 1) ? 1 : 0;
+
+        // The same process can lie in more than one of those directions, so make sure the update is sent to each process once.
+        int sentToNeighbours[8];
+        int sentToCount = 0;
+        for( int dx = minDx; dx <= maxDx; ++dx )
+        {
+            for( int dy = minDy; dy <= maxDy; ++dy )
+            {
+                int neighbourIndex = processNeighbourhood->getNeighbourIndexInDirection(dx, dy);
+                if( neighbourIndex == -1 || std::find(sentToNeighbours, sentToNeighbours + sentToCount, neighbourIndex) != sentToNeighbours + sentToCount )
+                {
+                    continue;
+                }
+
+                sentToNeighbours[sentToCount++] = neighbourIndex;
+                outgoingHaloUpdates[neighbourIndex].push_back(update);
+                hasUpdates = true;
+            }
+        }
+    }
 
-    repast::Point<int> immuneCellLoc(specialisedImmuneCellX, specialisedImmuneCellY);
-    discreteGridSpace->moveTo(newSpecialisedImmuneCellId, immuneCellLoc);
+    return hasUpdates;
 }
 
 
 
 /**********************
-*   VirusCellModel::printEndOfTimestep - Prints a statement that a timestep has finished.
+*   VirusCellModel::exchangeBoundaryEpithelialCellUpdates - Sends the queued updates of the boundary epithelial cells to the neighbouring processes,
+*   and applies the updates received from the neighbours to the local copies.
 **********************/
-void VirusCellModel::printEndOfTimestep(){
-    // Get the rank
-	int rank = repast::RepastProcess::instance()->rank();
-    // Print it only for one rank, as otherwise we'll get duplication of print statements.
-    if(rank == 0)
+void VirusCellModel::exchangeBoundaryEpithelialCellUpdates()
+{
+    processNeighbourhood->exchange(outgoingHaloUpdates, incomingHaloUpdates);
+    for( size_t i = 0; i < outgoingHaloUpdates.size(); ++i )
     {
-        std::cout<<"Timestep: "<<(int)repast::RepastProcess::instance()->getScheduleRunner().currentTick()<<std::endl;
+        outgoingHaloUpdates[i].clear();
     }
+
+    applyEpithelialCellHaloUpdates();
 }
 
 
 
 /**********************
-*   VirusCellModel::executeTimestep - Function which will execute the timestep. It will trigger all agents to act on each timestep.
+*   VirusCellModel::applyEpithelialCellHaloUpdates - Overwrites the buffer zone copies of the epithelial cells with the received updates.
+*   The updates of cells which have no copy on this process yet are ignored, as the projection synchronisation creates the copies with their current state.
 **********************/
-void VirusCellModel::executeTimestep()
+void VirusCellModel::applyEpithelialCellHaloUpdates()
 {
-    std::vector<VirusCellInteractionAgents*> theBufferZoneAgents;
-    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::NON_LOCAL, theBufferZoneAgents, 0, false);
-
-    std::vector<VirusCellInteractionAgents*>::iterator iter;
-
-    // First we need to check if the  agents in the bufferzones have requested division/infection to agents which are local to this rank.
-    // This is the only way to propagate changes to the original agents. 
-    // Otherwise, these modification would have been done to the copies of the agents rather than the originals and the changes would not reach the originals.
-    // In this way we ensure that the agents will act in an environmen where all agents are at their most up-to date state.
-    for( iter = theBufferZoneAgents.begin(); iter != theBufferZoneAgents.end(); ++iter )
+    std::vector<EpithelialCellHaloUpdate>::iterator updateIter;
+    for( updateIter = incomingHaloUpdates.begin(); updateIter != incomingHaloUpdates.end(); ++updateIter )
     {
-        if( (*iter)->getId().agentType() == 0 )
+        repast::AgentId cellId(updateIter->cellId, updateIter->cellStartRank, 0);
+        VirusCellInteractionAgents* theCellBaseClass = context.getAgent(cellId);
+        if( theCellBaseClass == nullptr )
         {
-            checkForCellDivision(*iter);
-            checkForCellToCellInfection(*iter);
+            continue;
         }
-    }
 
+        EpithelialCellAgent* theCell = static_cast<EpithelialCellAgent*>(theCellBaseClass);
+        theCell->set(theCell->getId().currentRank(), updateIter->lifespan, updateIter->age, 
+                    (EpithelialCellAgent::InternalState)updateIter->internalState, (EpithelialCellAgent::ExternalState)updateIter->externalState,
+                    updateIter->infectedLifespan, updateIter->timeInfected, updateIter->divisionRate, updateIter->timeSinceLastDivision, 
+                    updateIter->releaseDelay, updateIter->displayVirProteinsDelay,
+                    EpithelialCellAgent::NeighbouringCellModificationType::NoModification, repast::AgentId(-1, -1, -1, -1),
+                    updateIter->extracellularReleaseProb, updateIter->cellToCellTransmissionProb,
+                    updateIter->virionReleaseRate, 0, updateIter->virionReleaseRemainder);
+    }
+}
 
-    std::vector<VirusCellInteractionAgents*> theLocalAgents;
-    // Get the local agents and make them perform a step. This will include all agents: Epithelial cells, Virions, Specialised and Non-Specialised immune cells.
-    // They will also be in random order which will provide the stochasticity we need, as there is no way to make them act synchronously.
-    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theLocalAgents);
-
-    for( iter = theLocalAgents.begin(); iter != theLocalAgents.end(); ++iter )
-    {
-        (*iter)->doStep(&context, discreteGridSpace);
 
-        // For each specific type of agent we need if they have requested any change to the environment, which is only handled by the Virus_Cell_Model clas.
-        if( (*iter)->getId().agentType() == 0 )
-        {
-            // Check if the cell has requested division, viral release or infection of a neighbouring cell.
-            checkForCellDivision(*iter);
-            checkForCellVirionRelease(*iter);
-            checkForCellToCellInfection(*iter);
-        }
-        else if ((*iter)->getId().agentType() == 2 )
-        {
-            // Check if the innate immune cell has requested recruitment of other immune cells.
-            checkForInnateImmuneCellRecruitment(*iter);
-            checkForSpecialisedImmuneCellRecruitement(*iter);
-        }
-        else if( (*iter)->getId().agentType() == 3 )
-        {
-            // Check if the specialised immune cell has requested recruitment of other specialised immune cells.
-            checkForSpecialisedImmuneCellRecruitement(*iter);
-        }
-        
-        
-        // Check if the agent has died during the timestep and remove it from the simulation.
-        if( (*iter)->getId().agentType() != 0 )
-        {
-            removeLocalAgentIfDead(*iter);
-        }
-    } 
 
-    // Balancing the grid will identify the agents which have crossed the boundaries of their rank and need to be moved. 
-    discreteGridSpace->balance();
+/**********************
+*   VirusCellModel::findBoundaryEpithelialCells - Finds the epithelial cells on the boundary of this process's section of the grid, with their
+*   position in the section. The position of each cell is taken from the grid, rather than worked out from its id.
+**********************/
+void VirusCellModel::findBoundaryEpithelialCells()
+{
+    int localExtentX = discreteGridSpace->dimensions().extents().getX();
+    int localExtentY = discreteGridSpace->dimensions().extents().getY();
 
-    // Synchronising the agent status will move the agents to the correct process.
-    repast::RepastProcess::instance()->synchronizeAgentStatus<VirusCellInteractionAgents, VirusCellInteractionAgentPackage, VirusCellInteractionAgentsPackageProvider, 
-        VirusCellInteractionAgentsPackageReceiver>(context, *agentProvider, *agentReceiver, *agentReceiver);
+    boundaryEpithelialCells.clear();
+    boundaryEpithelialCellSet.clear();
 
-    // Synchronise the data about the section of the whole grid handled by each process. 
-    repast::RepastProcess::instance()->synchronizeProjectionInfo<VirusCellInteractionAgents, VirusCellInteractionAgentPackage, VirusCellInteractionAgentsPackageProvider, 
-        VirusCellInteractionAgentsPackageReceiver>(context, *agentProvider, *agentReceiver, *agentReceiver);
+    std::vector<VirusCellInteractionAgents*> theLocalEpithelialCells;
+    context.selectAgents(repast::SharedContext<VirusCellInteractionAgents>::LOCAL, theLocalEpithelialCells, 0, false);
 
-    // Synchronise all agents which are non-local to this process (The copies of non-local agents which this process owns).
-    // Ensures the buffer zone agents are most up-to-date copies of their original agents.
-    repast::RepastProcess::instance()->synchronizeAgentStates<VirusCellInteractionAgentPackage, VirusCellInteractionAgentsPackageProvider, 
-        VirusCellInteractionAgentsPackageReceiver>(*agentProvider, *agentReceiver);
+    std::vector<VirusCellInteractionAgents*>::iterator iter;
+    for( iter = theLocalEpithelialCells.begin(); iter != theLocalEpithelialCells.end(); ++iter )
+    {
+        std::vector<int> cellLocation;
+        discreteGridSpace->getLocation((*iter)->getId(), cellLocation);
+        int x = cellLocation[0] - discreteGridSpace->dimensions().origin().getX();
+        int y = cellLocation[1] - discreteGridSpace->dimensions().origin().getY();
+        if( x == 0 || y == 0 || x == localExtentX - 1 || y == localExtentY - 1 )
+        {
+            BoundaryEpithelialCell boundaryCell;
+            boundaryCell.cell = static_cast<EpithelialCellAgent*>(*iter);
+            boundaryCell.x = x;
+            boundaryCell.y = y;
+            boundaryEpithelialCells.push_back(boundaryCell);
+            boundaryEpithelialCellSet.insert(*iter);
+        }
+    }
 }
 
 
@@ -625,19 +1968,16 @@ void VirusCellModel::checkForCellDivision(VirusCellInteractionAgents* theEpithel
 
         // Get the id of the neighbouring cell where the division will happen.
         repast::AgentId cellToDivideIntoId = epithelialCell->getNeighbouringCellToModify();
-        if(cellToDivideIntoId.id() != -1 && cellToDivideIntoId.agentType() == 0 && rank == cellToDivideIntoId.currentRank())
+        if(cellToDivideIntoId.id() != -1 && cellToDivideIntoId.agentType() == 0)
         {
-            VirusCellInteractionAgents* cellToBeRevivedBaseClass = context.getAgent(cellToDivideIntoId);  
-            EpithelialCellAgent* cellToBeRevived = static_cast<EpithelialCellAgent*>(cellToBeRevivedBaseClass);
-
-            // Dividing, will reset the agent's computational object with new parameters (revives it with new parameters).
-            // Ensure we revive only dead cells. Since cross-process agent synchronisation happens at the end of the step,
-            // There could potentially be some inconsistencies (local cell trying to revive a cell and a buffer zone cell trying to revive the same cell)
-            // These inconsistencies are prevented by checking the cell state and ensuring it is dead.
-            if(cellToBeRevived->getInternalState() == EpithelialCellAgent::InternalState::Dead)
+            // Divide straight away if the cell is local, otherwise request the division from the process which owns the cell.
+            if( rank == cellToDivideIntoId.currentRank() )
             {
-                // Reinitialise the epithelial cell agent (Carry the division out).
-                initialiseEpithelialCellAgent(-1, -1, -1, true, cellToBeRevived);
+                divideIntoLocalCell(cellToDivideIntoId);
+            }
+            else
+            {
+                requestNeighbouringCellModification(EpithelialCellAgent::NeighbouringCellModificationType::ToDivideInto, cellToDivideIntoId);
             }
         }
     }
@@ -645,6 +1985,27 @@ void VirusCellModel::checkForCellDivision(VirusCellInteractionAgents* theEpithel
 
 
 
+/**********************
+*   VirusCellModel::divideIntoLocalCell - Carries out the division of an epithelial cell into a dead epithelial cell agent which is local to this process.
+**********************/
+void VirusCellModel::divideIntoLocalCell(repast::AgentId cellToDivideIntoId)
+{
+    VirusCellInteractionAgents* cellToBeRevivedBaseClass = context.getAgent(cellToDivideIntoId);  
+    EpithelialCellAgent* cellToBeRevived = static_cast<EpithelialCellAgent*>(cellToBeRevivedBaseClass);
+
+    // Dividing, will reset the agent's computational object with new parameters (revives it with new parameters).
+    // Ensure we revive only dead cells. Since the division requests of cells on neighbouring processes arrive at the end of the step,
+    // There could potentially be some inconsistencies (local cell trying to revive a cell and a neighbouring process cell trying to revive the same cell)
+    // These inconsistencies are prevented by checking the cell state and ensuring it is dead.
+    if(cellToBeRevived != nullptr && cellToBeRevived->getInternalState() == EpithelialCellAgent::InternalState::Dead)
+    {
+        // Reinitialise the epithelial cell agent (Carry the division out).
+        initialiseEpithelialCellAgent(-1, -1, -1, true, cellToBeRevived);
+    }
+}
+
+
+
 /**********************
 *   VirusCellModel::checkForCellToCellInfection - Function which checks if an Epithelial Cell agent is to infect a neighbouring cell through 
 *   Cell-to-Cell virus transmission release. If it is, then it infects the corresponding neighbouring cell.
@@ -669,18 +2030,85 @@ void VirusCellModel::checkForCellToCellInfection(VirusCellInteractionAgents* the
 
         // Get the id of the neighbouring cell which is to be infected.
         repast::AgentId cellToInfectId = epithelialCell->getNeighbouringCellToModify();
-        if(cellToInfectId.id() != -1 && cellToInfectId.agentType() == 0 && rank == cellToInfectId.currentRank())
+        if(cellToInfectId.id() != -1 && cellToInfectId.agentType() == 0)
         {
-            VirusCellInteractionAgents* cellToInfectBaseClass = context.getAgent(cellToInfectId);  
-            EpithelialCellAgent* cellToBeInfected = static_cast<EpithelialCellAgent*>(cellToInfectBaseClass);
-
-            // Ensure we infect only healthy cells. Since cross-process agent synchronisation happens at the end of the step,
-            // There could potentially be some inconsistencies (local cell trying to revive a cell and a buffer zone cell trying to infect the same cell)
-            // These inconsistencies are prevented by checking the cell state and ensuring it is healthy.
-            if(cellToBeInfected->getInternalState() == EpithelialCellAgent::InternalState::Healthy)
+            // Infect straight away if the cell is local, otherwise request the infection from the process which owns the cell.
+            if( rank == cellToInfectId.currentRank() )
             {
-                cellToBeInfected->infect();
+                infectLocalCell(cellToInfectId);
             }
+            else
+            {
+                requestNeighbouringCellModification(EpithelialCellAgent::NeighbouringCellModificationType::ToInfect, cellToInfectId);
+            }
+        }
+    }
+}
+
+
+
+/**********************
+*   VirusCellModel::infectLocalCell - Carries out the cell-to-cell infection of an epithelial cell agent which is local to this process.
+**********************/
+void VirusCellModel::infectLocalCell(repast::AgentId cellToInfectId)
+{
+    VirusCellInteractionAgents* cellToInfectBaseClass = context.getAgent(cellToInfectId);  
+    EpithelialCellAgent* cellToBeInfected = static_cast<EpithelialCellAgent*>(cellToInfectBaseClass);
+
+    // Ensure we infect only healthy cells. Since the infection requests of cells on neighbouring processes arrive at the end of the step,
+    // There could potentially be some inconsistencies (local cell trying to revive a cell and a neighbouring process cell trying to infect the same cell)
+    // These inconsistencies are prevented by checking the cell state and ensuring it is healthy.
+    if(cellToBeInfected != nullptr && cellToBeInfected->getInternalState() == EpithelialCellAgent::InternalState::Healthy)
+    {
+        cellToBeInfected->infect();
+    }
+}
+
+
+
+/**********************
+*   VirusCellModel::requestNeighbouringCellModification - Queues a division/infection request for an epithelial cell which is local to a neighbouring process.
+*   The queued requests are sent to their processes once all boundary cells have acted (see executeTimestep).
+**********************/
+void VirusCellModel::requestNeighbouringCellModification(EpithelialCellAgent::NeighbouringCellModificationType typeOfModification, repast::AgentId cellToModifyId)
+{
+    int neighbourIndex = processNeighbourhood->getNeighbourIndex(cellToModifyId.currentRank());
+    if( neighbourIndex == -1 )
+    {
+        std::cout<<"The cell to modify requested by an epithelial cell is not on a neighbouring process! The request is ignored."<<std::endl;
+        return;
+    }
+
+    NeighbouringCellModificationRequest request;
+    request.typeOfModification = typeOfModification;
+    request.cellToModifyId = cellToModifyId.id();
+    request.cellToModifyStartRank = cellToModifyId.startingRank();
+    request.cellToModifyType = cellToModifyId.agentType();
+
+    outgoingModificationRequests[neighbourIndex].push_back(request);
+}
+
+
+
+/**********************
+*   VirusCellModel::applyNeighbouringCellModificationRequests - Carries out the division/infection requests received from the neighbouring processes on the local cells.
+**********************/
+void VirusCellModel::applyNeighbouringCellModificationRequests()
+{
+    int rank = repast::RepastProcess::instance()->rank();
+
+    std::vector<NeighbouringCellModificationRequest>::iterator requestIter;
+    for( requestIter = incomingModificationRequests.begin(); requestIter != incomingModificationRequests.end(); ++requestIter )
+    {
+        repast::AgentId cellToModifyId(requestIter->cellToModifyId, requestIter->cellToModifyStartRank, requestIter->cellToModifyType, rank);
+
+        if( requestIter->typeOfModification == EpithelialCellAgent::NeighbouringCellModificationType::ToDivideInto )
+        {
+            divideIntoLocalCell(cellToModifyId);
+        }
+        else if( requestIter->typeOfModification == EpithelialCellAgent::NeighbouringCellModificationType::ToInfect )
+        {
+            infectLocalCell(cellToModifyId);
         }
     }
 }
@@ -786,8 +2214,9 @@ void VirusCellModel::checkForInnateImmuneCellRecruitment(VirusCellInteractionAge
 *   We will ignore the Epithelial cell agents, since they are not removed from the simulation if they die.
 *   That is since, epithelial cells can divide, and the division of a cell will basically "revive" a dead cell.
 *   This will remove the need to create a new epithelial cell agent in the simulation.
+*   Returns whether the agent has been removed.
 **********************/
-void VirusCellModel::removeLocalAgentIfDead(VirusCellInteractionAgents* theAgent)
+bool VirusCellModel::removeLocalAgentIfDead(VirusCellInteractionAgents* theAgent)
 {
     repast::AgentId theAgentId = theAgent->getId();
     int theAgentType = theAgentId.agentType();
@@ -836,6 +2265,8 @@ void VirusCellModel::removeLocalAgentIfDead(VirusCellInteractionAgents* theAgent
     {
         repast::RepastProcess::instance()->agentRemoved( theAgentId );
         context.removeAgent( theAgentId );
+        PopulationCounters::instance()->mobileAgentRemoved(theAgentType);
     }
 
+    return removeAgent;
 }
\ No newline at end of file